@@ -0,0 +1,319 @@
+#pragma once
+#ifndef AuxPort_Analyzer_H
+#define AuxPort_Analyzer_H
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "BackgroundWorker.h"
+#include "FFT.h"
+#include "LockFree.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Struct] One analyzer frame for the GUI: smoothed and peak-held levels in dBFS (a full
+	scale sine reads 0) for numBands log spaced bands from 20 Hz to 20 kHz, for the Effect's
+	input and output. Bands above the analysis Nyquist read floorDb.
+*/
+/*===================================================================================*/
+	struct SpectrumFrame
+	{
+		static constexpr size_t numBands = 96;
+		static constexpr float floorDb = -120.0f;
+
+		float input[numBands] = {};
+		float output[numBands] = {};
+		float inputPeak[numBands] = {};
+		float outputPeak[numBands] = {};
+		uint64_t sequence = 0;
+
+		static double bandFrequency(size_t band)
+		{
+			return 20.0 * std::pow(1000.0, static_cast<double>(band) / static_cast<double>(numBands - 1));
+		}
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Spectrum analyzer fed from the audio thread, computed on the BackgroundWorker
+
+	The audio thread only averages the mono input and output down to the analysis rate (44.1
+	or 48 kHz; hosts running faster are decimated by a whole factor) and copies them into
+	two SpscRings; it never runs an FFT and, while the analyzer is stopped, it only checks a
+	flag. The worker takes fftSize point Hann windowed FFTs every hop samples, folds the
+	bins into SpectrumFrame bands, applies the release and peak-hold ballistics and
+	publishes the frame through a TripleBuffer. The GUI picks the newest frame up with
+	update()/read() on its timer. When the worker falls behind, the rings drop the newest
+	samples instead of blocking the audio thread.
+*/
+/*===================================================================================*/
+	class SpectrumAnalyzer : public BackgroundTask
+	{
+	public:
+		static constexpr size_t fftSize = 2048;
+		static constexpr size_t hop = 512;
+		static constexpr float releaseDbPerSecond = 36.0f;
+		static constexpr float peakHoldSeconds = 1.0f;
+		static constexpr float peakFallDbPerSecond = 18.0f;
+
+		SpectrumAnalyzer() = default;
+		~SpectrumAnalyzer()
+		{
+			stop();
+		}
+/*===================================================================================*/
+/*
+	[Function] Sets up for sampleRate and clears everything (allocates; from reset(), not
+	from the audio thread). A running analyzer keeps running.
+*/
+		void prepare(double sampleRate)
+		{
+			const bool wasRunning = attached;
+			stop();
+			decimation = std::max<size_t>(1, static_cast<size_t>(std::floor(sampleRate / 44100.0)));
+			analysisRate = sampleRate / static_cast<double>(decimation);
+			fft.prepare(fftSize);
+			window.resize(fftSize);
+			const double pi = 3.14159265358979323846;
+			for (size_t i = 0; i < fftSize; i++)
+				window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * static_cast<double>(i) / static_cast<double>(fftSize)));
+			spectrumRe.assign(fft.bins(), 0.0f);
+			spectrumIm.assign(fft.bins(), 0.0f);
+			windowed.assign(fftSize, 0.0f);
+			mapBands();
+			for (Channel& channel : channels)
+			{
+				channel.ring.prepare(4 * fftSize);
+				channel.history.assign(fftSize, 0.0f);
+				channel.sum = 0.0f;
+				channel.count = 0;
+				std::fill(channel.level, channel.level + SpectrumFrame::numBands, SpectrumFrame::floorDb);
+				std::fill(channel.peak, channel.peak + SpectrumFrame::numBands, SpectrumFrame::floorDb);
+				std::fill(channel.held, channel.held + SpectrumFrame::numBands, 0.0f);
+			}
+			const float frameSeconds = static_cast<float>(hop / analysisRate);
+			release = releaseDbPerSecond * frameSeconds;
+			peakFall = peakFallDbPerSecond * frameSeconds;
+			holdFrames = peakHoldSeconds / frameSeconds;
+			pending = 0;
+			sequence = 0;
+			if (wasRunning)
+				start();
+		}
+/*===================================================================================*/
+/*
+	[Function] Starts / stops the analysis (GUI open / close; not from the audio thread)
+*/
+		void start()
+		{
+			if (attached || window.empty())
+				return;
+			BackgroundWorker::get().attach(this);
+			attached = true;
+			running.store(true, std::memory_order_release);
+		}
+
+		void stop()
+		{
+			running.store(false, std::memory_order_release);
+			if (!attached)
+				return;
+			BackgroundWorker::get().detach(this);
+			attached = false;
+		}
+
+		bool isRunning() const
+		{
+			return running.load(std::memory_order_relaxed);
+		}
+/*===================================================================================*/
+/*
+	[Function] Audio thread: the Effect's input (left/right, averaged) before it is
+	processed, and its output after
+*/
+		template<class S>
+		void pushInput(const S* left, const S* right, size_t numSamples)
+		{
+			if (running.load(std::memory_order_relaxed))
+				feed(channels[0], left, right, numSamples);
+		}
+
+		template<class S>
+		void pushOutput(const S* output, size_t numSamples)
+		{
+			if (!running.load(std::memory_order_relaxed))
+				return;
+			feed(channels[1], output, output, numSamples);
+			pending += numSamples;
+			if (pending >= hop * decimation)
+			{
+				pending = 0;
+				requestService();
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] GUI thread: picks up the newest frame, true if there is a new one since the
+	last call; read() is the frame
+*/
+		bool update()
+		{
+			return frames.update();
+		}
+
+		const SpectrumFrame& read() const
+		{
+			return frames.read();
+		}
+/*===================================================================================*/
+/*
+	[Function] Worker thread: analyzes every complete hop in the rings and publishes
+*/
+		void service() override
+		{
+			bool fresh = false;
+			for (Channel& channel : channels)
+			{
+				while (channel.ring.available() >= hop)
+				{
+					std::memmove(channel.history.data(), channel.history.data() + hop, (fftSize - hop) * sizeof(float));
+					channel.ring.pop(channel.history.data() + fftSize - hop, hop);
+					analyze(channel);
+					fresh = true;
+				}
+			}
+			if (!fresh)
+				return;
+			SpectrumFrame& frame = frames.write();
+			std::memcpy(frame.input, channels[0].level, sizeof(frame.input));
+			std::memcpy(frame.output, channels[1].level, sizeof(frame.output));
+			std::memcpy(frame.inputPeak, channels[0].peak, sizeof(frame.inputPeak));
+			std::memcpy(frame.outputPeak, channels[1].peak, sizeof(frame.outputPeak));
+			frame.sequence = ++sequence;
+			frames.publish();
+		}
+	private:
+		struct Channel
+		{
+			SpscRing<float> ring;
+			std::vector<float> history;		// the last fftSize samples, oldest first
+			float sum = 0.0f;				// decimator
+			size_t count = 0;
+			float level[SpectrumFrame::numBands];
+			float peak[SpectrumFrame::numBands];
+			float held[SpectrumFrame::numBands];	// frames the peak has been held for
+		};
+/*===================================================================================*/
+/*
+	[Function] Averages numSamples of (a + b) / 2 down by decimation into the ring, a few
+	hundred samples at a time through a stack buffer
+*/
+		template<class S>
+		void feed(Channel& channel, const S* a, const S* b, size_t numSamples)
+		{
+			float decimated[256];
+			if (decimation == 1)
+			{
+				for (size_t start = 0; start < numSamples; start += 256)
+				{
+					const size_t count = std::min<size_t>(256, numSamples - start);
+					for (size_t i = 0; i < count; i++)
+						decimated[i] = 0.5f * (static_cast<float>(a[start + i]) + static_cast<float>(b[start + i]));
+					channel.ring.push(decimated, count);
+				}
+				return;
+			}
+			const float scale = 0.5f / static_cast<float>(decimation);
+			size_t produced = 0;
+			for (size_t i = 0; i < numSamples; i++)
+			{
+				channel.sum += static_cast<float>(a[i]) + static_cast<float>(b[i]);
+				if (++channel.count < decimation)
+					continue;
+				decimated[produced++] = channel.sum * scale;
+				channel.sum = 0.0f;
+				channel.count = 0;
+				if (produced == 256)
+				{
+					channel.ring.push(decimated, produced);
+					produced = 0;
+				}
+			}
+			channel.ring.push(decimated, produced);
+		}
+/*===================================================================================*/
+/*
+	[Function] Band b takes the loudest bin from bandStart[b] to bandEnd[b] (at least one bin)
+*/
+		void mapBands()
+		{
+			const double binHz = analysisRate / static_cast<double>(fftSize);
+			const double nyquist = analysisRate / 2.0;
+			const double step = std::pow(1000.0, 0.5 / static_cast<double>(SpectrumFrame::numBands - 1));
+			for (size_t band = 0; band < SpectrumFrame::numBands; band++)
+			{
+				const double centre = SpectrumFrame::bandFrequency(band);
+				if (centre >= nyquist)
+				{
+					bandStart[band] = bandEnd[band] = 0;
+					continue;
+				}
+				size_t first = static_cast<size_t>(std::ceil(centre / step / binHz));
+				size_t last = static_cast<size_t>(std::floor(std::min(centre * step, nyquist) / binHz));
+				if (last < first)
+					first = last = static_cast<size_t>(std::lround(centre / binHz));
+				bandStart[band] = std::max<size_t>(first, 1);
+				bandEnd[band] = std::max(last, bandStart[band]) + 1;
+			}
+		}
+
+		void analyze(Channel& channel)
+		{
+			for (size_t i = 0; i < fftSize; i++)
+				windowed[i] = channel.history[i] * window[i];
+			fft.forward(windowed.data(), spectrumRe.data(), spectrumIm.data());
+			// a full scale sine peaks at fftSize / 4 through the Hann window
+			const float normalizer = 16.0f / (static_cast<float>(fftSize) * static_cast<float>(fftSize));
+			for (size_t band = 0; band < SpectrumFrame::numBands; band++)
+			{
+				float power = 0.0f;
+				for (size_t bin = bandStart[band]; bin < bandEnd[band]; bin++)
+					power = std::max(power, spectrumRe[bin] * spectrumRe[bin] + spectrumIm[bin] * spectrumIm[bin]);
+				const float db = bandEnd[band] == 0 ? SpectrumFrame::floorDb : std::max(SpectrumFrame::floorDb, 10.0f * std::log10(power * normalizer + 1e-30f));
+				channel.level[band] = std::max(db, channel.level[band] - release);
+				if (db >= channel.peak[band])
+				{
+					channel.peak[band] = db;
+					channel.held[band] = 0.0f;
+				}
+				else if (++channel.held[band] > holdFrames)
+					channel.peak[band] = std::max(channel.level[band], channel.peak[band] - peakFall);
+			}
+		}
+
+		Channel channels[2];
+		RealFFT<float> fft;
+		std::vector<float> window;
+		std::vector<float> windowed;
+		std::vector<float> spectrumRe;
+		std::vector<float> spectrumIm;
+		size_t bandStart[SpectrumFrame::numBands] = {};
+		size_t bandEnd[SpectrumFrame::numBands] = {};
+		TripleBuffer<SpectrumFrame> frames;
+		uint64_t sequence = 0;
+
+		size_t decimation = 1;
+		double analysisRate = 48000.0;
+		float release = 0.0f;
+		float peakFall = 0.0f;
+		float holdFrames = 0.0f;
+		size_t pending = 0;
+		bool attached = false;
+		std::atomic<bool> running{ false };
+	};
+}
+#endif
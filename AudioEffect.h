@@ -36,11 +36,22 @@
 			OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
+#include <cstring>
 #include <vector>
 #include <math.h>
 #include "plugincore.h"
 #include "fxobjects.h"
 #include "FX.h"
+#include "Expression.h"
+#include "Graph.h"
+#include "Formats.h"
+#include "Parameters.h"
+#include "Resampler.h"
+#include "Governor.h"
+#include "Snapshot.h"
+#include "Convolver.h"
+#include "Analyzer.h"
+#include "Limiter.h"
 namespace AuxPort
 {
 
@@ -77,11 +88,11 @@ namespace AuxPort
 		Effect<bufferType, effectType>(const Effect<bufferType, effectType>& kernel) = default;
 /*===================================================================================*/
 /*
-	[Function] Set your Control Addresses (DONT MESS WITH IT)
+	[Function] Points the kernel at an instance's control values (DONT MESS WITH IT)
 */
-		void push(void* parameterAddress, const boundVariableType& dataType,int controlNumber)
+		void bind(const ControlBlock& block)
 		{
-			_controls.push_back({parameterAddress,dataType,controlNumber});
+			controls = block;
 		}
 /*===================================================================================*/
 /*
@@ -92,15 +103,256 @@ namespace AuxPort
 			/*
 				Update Internal Parameters of your FX Objects here
 			*/
+			const double rate = resampling ? internalRate : static_cast<double>(sampleRate);
+			lowPass.setSampleRate(rate);
+			highPass.setSampleRate(rate);
+			bandPass.setSampleRate(rate);
+			crossover.setSampleRate(rate);
+			reduced.setSampleRate(rate, rate);
+			minimal.setSampleRate(rate, rate / 2);
+
 			lowPass.setFilterType(filterAlgorithm::kButterLPF2);
-			lowPass.setParameters(getControl(controlID::lowPassFC), getControl(controlID::lowPass_Q), getControl(controlID::lpfBoost));
+			highPass.setFilterType(filterAlgorithm::kButterHPF2);
+			bandPass.setFilterType(filterAlgorithm::kBPF2);
 
+			Designs request;
+			describeDesigns(request);
+			for (int i = 0; i < numDesigns; i++)
+			{
+				const CoefficientKey& key = request.keys[i];
+				designedFilter(i).setParameters(static_cast<effectType>(key.fc), static_cast<effectType>(key.Q), static_cast<effectType>(key.boostCut));
+			}
+		}
+/*===================================================================================*/
+/*
+	[Struct] Coefficient designs for every filter of the kernel (the three of each tier), so
+	they can be designed off the audio thread: describeDesigns() fills in the keys from the
+	current controls, design() computes them anywhere, applyDesigns() installs them.
+*/
+		static constexpr int numDesigns = 9;
+		struct Designs
+		{
+			CoefficientKey keys[numDesigns];
+			double coefficients[numDesigns][5] = {};
+		};
+/*===================================================================================*/
+/*
+	[Function] Audio thread: the keys the controls call for right now (reads only)
+*/
+		void describeDesigns(Designs& designs)
+		{
+			for (int i = 0; i < numDesigns; i++)
+			{
+				const int* id = designControls[i % 3];
+				designs.keys[i] = designedFilter(i).keyFor(getControl(id[0]), getControl(id[1]), getControl(id[2]));
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Any thread: computes the coefficients for the keys (through the CoefficientCache)
+*/
+		static void design(Designs& designs)
+		{
+			for (int i = 0; i < numDesigns; i++)
+				Filter<bufferType, effectType>::design(designs.keys[i], designs.coefficients[i]);
+		}
+/*===================================================================================*/
+/*
+	[Function] Audio thread, at a block boundary: installs the designs (no computation). The
+	filter state is kept, exactly as with a synchronous setParameters(); designs made for
+	another sample rate are skipped. While the sidechain is moving the cutoffs, the tiers in
+	use are retuned straight away so the unmodulated designs are never heard.
+*/
+		void applyDesigns(const Designs& designs)
+		{
+			for (int i = 0; i < numDesigns; i++)
+				designedFilter(i).setDesign(designs.keys[i], designs.coefficients[i]);
+			if (modulated)
+				retune();
+		}
+/*===================================================================================*/
+/*
+	[Function] Clears the state of your FX Objects and sets them up for a new Sample Rate
+*/
+		void reset(const bufferType& sampleRate)
+		{
+			double rate = static_cast<double>(sampleRate);
+			if (convolver)
+				convolver->prepare(rate);
+			limiter.prepare(rate);
+			follower.reset(rate);
+			duck = bufferType(1);
+			modulated = false;
+			cutoffRatio = 1.0;
+			controlCountdown = 0;
+			resampling = internalRate > 0 && std::llround(internalRate) != std::llround(rate) && prepareResamplers(rate);
+			if (resampling)
+				rate = internalRate;
+			lowPass.reset(rate);
+			highPass.reset(rate);
+			bandPass.reset(rate);
+			crossover.reset(rate);
+			fullWave.reset();
+			reduced.reset(rate, rate);
+			minimal.reset(rate, rate / 2);
+			decimator = Decimator();
+			tierFade = 0;
+			for (Branch& branch : branches)
+				branch.fade = 0;
+			if (graph)
+				graph->reset(rate);
+			// room for restore()'s copy of the state, with every control bound, so it never allocates
+			snapshot(rollback);
+			rollback.reserve(rollback.size() + maxControlID * (sizeof(int32_t) + sizeof(float)));
+		}
+/*===================================================================================*/
+/*
+	[Function] Runs the DSP at a fixed internal rate (0 = the host rate) with polyphase
+	resampling at the edges. Takes effect at the next reset(); if the host/internal ratio
+	is too awkward for the resampler, reset() falls back to the host rate.
+*/
+		void setInternalRate(double rate)
+		{
+			internalRate = rate > 0 ? rate : 0.0;
+		}
 
-			highPass.setFilterType(filterAlgorithm::kButterHPF2);
-			highPass.setParameters(getControl(controlID::highPassFC), getControl(controlID::highPassQ), getControl(controlID::hpfBoost));
+		double getInternalRate() const
+		{
+			return internalRate;
+		}
 
-			bandPass.setFilterType(filterAlgorithm::kBPF2);
-			bandPass.setParameters(getControl(controlID::bandPassFC), getControl(controlID::bandPassQ), getControl(controlID::bandPassBoost));
+		bool isResampling() const
+		{
+			return resampling;
+		}
+/*===================================================================================*/
+/*
+	[Function] Delay added by the internal-rate mode and the limiter's lookahead, in host
+	samples (0 when both are off)
+*/
+		size_t getLatencySamples() const
+		{
+			const size_t lookahead = limiter.getLatencySamples();
+			if (!resampling)
+				return lookahead;
+			const double ratio = internalRate / hostRate;
+			return static_cast<size_t>(std::llround(upLeft.latency() / ratio + down.latency())) + fifoPriming + lookahead;
+		}
+/*===================================================================================*/
+/*
+	[Function] Lookahead of the output limiter in milliseconds (0 = no limiter); takes
+	effect at the next reset(). The limiter itself is switched by the Limiter control, but
+	the lookahead delay stays in whenever it is set, so the reported latency never changes
+	with the switch.
+*/
+		void setLookahead(double ms)
+		{
+			limiter.setLookahead(ms);
+		}
+
+		double getLookahead() const
+		{
+			return limiter.getLookahead();
+		}
+/*===================================================================================*/
+/*
+	[Function] Runs a compiled Graph instead of the built-in signal flow (nullptr switches
+	back). The Effect doesn't own the graph; its controls are read through bind()/getControl.
+*/
+		void load(Graph<bufferType, effectType>* flow)
+		{
+			graph = flow && flow->isCompiled() ? flow : nullptr;
+			if (graph)
+				graph->setAccuracy(tier == Tier::Full ? Accuracy::High : Accuracy::Low);
+		}
+/*===================================================================================*/
+/*
+	[Function] Convolves the final mix with a cabinet / impulse response at the host rate
+	(nullptr removes it). The Effect doesn't own the Convolver; reset() prepares it for the
+	rate, so load it before reset(). It adds no latency.
+*/
+		void loadCabinet(Convolver<bufferType>* stage)
+		{
+			convolver = stage && stage->hasImpulse() ? stage : nullptr;
+		}
+/*===================================================================================*/
+/*
+	[Function] Feeds the input and output to a SpectrumAnalyzer (nullptr removes it). The
+	Effect doesn't own it; while it isn't running this costs one flag check per block.
+*/
+		void loadAnalyzer(SpectrumAnalyzer* feed)
+		{
+			analyzer = feed;
+		}
+/*===================================================================================*/
+/*
+	[Function] Block run with a sidechain (right = nullptr for a mono sidechain). The
+	envelope of the sidechain moves the low, high and band pass cutoffs by up to SC_Cutoff
+	octaves and ducks masterD by up to SC_Duck, updated every getControlInterval() samples.
+*/
+		void run(const bufferType* inputLeft, const bufferType* inputRight, bufferType* outputLeft, bufferType* outputRight, size_t numSamples,
+			const bufferType* sidechainLeft, const bufferType* sidechainRight)
+		{
+			sidechain[0] = sidechainLeft;
+			sidechain[1] = sidechainRight ? sidechainRight : sidechainLeft;
+			run(inputLeft, inputRight, outputLeft, outputRight, numSamples);
+			sidechain[0] = sidechain[1] = nullptr;
+		}
+
+		void run(Frame<bufferType>& frame, const Frame<bufferType>& sidechainFrame)
+		{
+			sidechain[0] = &sidechainFrame.left;
+			sidechain[1] = &sidechainFrame.right;
+			run(frame);
+			sidechain[0] = sidechain[1] = nullptr;
+		}
+/*===================================================================================*/
+/*
+	[Function] Control rate of the sidechain modulation, in host samples: the follower and
+	the cutoff redesigns run once per interval, never per sample
+*/
+		void setControlInterval(size_t samples)
+		{
+			controlInterval = samples < 1 ? 1 : (samples > maxSubBlockSize ? maxSubBlockSize : samples);
+		}
+
+		size_t getControlInterval() const
+		{
+			return controlInterval;
+		}
+/*===================================================================================*/
+/*
+	[Function] Switches the processing tier (audio thread safe, no allocation). The tiers
+	trade a little fidelity for CPU:
+
+		Full     the reference signal flow
+		Reduced  one high pass on the weighted L/R sum instead of one per side
+		Minimal  as Reduced, with the distortion branch run at half rate (2:1 down, linear
+		         interpolation up)
+
+	The Crossover control only applies to Full; the cheaper tiers keep their own filters.
+	A loaded Graph only switches its arctan shapers to lookup tables below Full. The tier
+	dependent stages of the old and new tier run side by side for tierFadeLength samples
+	and are crossfaded, so a switch never clicks.
+*/
+		void setTier(Tier newTier)
+		{
+			if (newTier == tier)
+				return;
+			previousTier = tier;
+			tier = newTier;
+			tierFade = tierFadeLength;
+			clearDistortion(tier);
+			highPassFor(tier).clearState();
+			if (tier == Tier::Full)
+				crossover.clearState();
+			if (graph)
+				graph->setAccuracy(tier == Tier::Full ? Accuracy::High : Accuracy::Low);
+		}
+
+		Tier getTier() const
+		{
+			return tier;
 		}
 /*===================================================================================*/
 /*
@@ -125,31 +377,53 @@ namespace AuxPort
 			/*
 				Start
 			*/
-			FX<float>::PreGain(leftChannel, getControl(controlID::preGain));
-			FX<float>::PreGain(rightChannel, getControl(controlID::preGain));
-
-			bufferType lowPassLeft = lowPass.process(leftChannel);
-			bufferType lowPassRight = lowPass.process(rightChannel);
-
-			bufferType monoLowPass = FX<float>::stereoToMono(lowPassLeft, lowPassRight);
-
-			monoLowPass = fullWave.process(monoLowPass, getControl(controlID::fullWaveSwitch));
-			monoLowPass = bandPass.process(monoLowPass);
-
-			bufferType highPassLeft = highPass.process(leftChannel);
-			bufferType highPassRight = highPass.process(rightChannel);
+			if (resampling || convolver || (analyzer && analyzer->isRunning()) || modulating() || tier != Tier::Full || tierFade > 0 ||
+				getControl(controlID::crossoverMode) != effectType(0))
+			{
+				bufferType out;
+				render(&frame.left, &frame.right, &out, 1);
+				frame.left = out;
+				frame.right = out;
+				return;
+			}
+			if (graph)
+			{
+				bufferType out;
+				graph->update([this](int id) { return getControl(id); });
+				graph->process(&frame.left, &frame.right, &out, 1);
+				limit(&out, 1);
+				frame.left = out;
+				frame.right = out;
+				return;
+			}
+			cookGains();
+			/*
+				preGain and masterD * (A1 + A2) live in the filter numerators (see compileMix);
+				branches whose weight is exactly zero are skipped (see updateBranches)
+			*/
+			bufferType monoLowPass = 0;
+			if (branches[distortion].live)
+			{
+				bufferType lowPassLeft = lowPass.process(leftChannel, 0);
+				bufferType lowPassRight = lowPass.process(rightChannel, 1);
 
-			
+				monoLowPass = FX<bufferType>::stereoToMono(lowPassLeft, lowPassRight);
 
+				monoLowPass = fullWave.process(monoLowPass, gains.fullWave);
+				monoLowPass = fadeIn(branches[distortion], bandPass.process(monoLowPass));
+			}
 
-			
-			bufferType sum = (getControl(controlID::A1)*FX<float>::accumulate({ highPassRight,monoLowPass })) + 
-							 (getControl(controlID::A2)*FX<float>::accumulate({ monoLowPass,highPassLeft }));
+			bufferType highPassLeft = 0;
+			bufferType highPassRight = 0;
+			if (branches[highPassLeftBranch].live)
+				highPassLeft = fadeIn(branches[highPassLeftBranch], highPass.process(leftChannel, 0));
+			if (branches[highPassRightBranch].live)
+				highPassRight = fadeIn(branches[highPassRightBranch], highPass.process(rightChannel, 1));
 
-			sum = FX<float>::accumulate({
-											getControl(controlID::masterD) * sum,
-											getControl(controlID::masterC) * FX<float>::stereoToMono(frame.left,frame.right)
-										});
+			bufferType sum = mix.highPassLeft * highPassLeft + mix.highPassRight * highPassRight + monoLowPass;
+			if (branches[clean].live)
+				sum += mix.clean * FX<bufferType>::stereoToMono(frame.left, frame.right);
+			limit(&sum, 1);
 
 			leftChannel = sum;
 			rightChannel = sum;
@@ -165,70 +439,1098 @@ namespace AuxPort
 			frame.left = leftChannel;
 			frame.right = rightChannel;
 		}
+/*===================================================================================*/
+/*
+	[Function] Block version of run(): processes numSamples samples of left/right in place.
+	Pass right = nullptr for mono; left is then used for both inputs and gets the result.
+*/
+		void run(bufferType* left, bufferType* right, size_t numSamples)
+		{
+			run(left, right ? right : left, left, right, numSamples);
+		}
+/*===================================================================================*/
+/*
+	[Function] Out-of-place block run: reads inputLeft/inputRight and writes the result to
+	outputLeft (and outputRight unless it is nullptr). The outputs may alias the inputs, so
+	a host's separate in/out buffers need no copy first.
+*/
+		void run(const bufferType* inputLeft, const bufferType* inputRight, bufferType* outputLeft, bufferType* outputRight, size_t numSamples)
+		{
+			render(inputLeft, inputRight, outputLeft, numSamples);
+			if (outputRight && outputRight != outputLeft)
+				std::memcpy(outputRight, outputLeft, numSamples * sizeof(bufferType));
+		}
+/*===================================================================================*/
+/*
+	[Function] Runs interleaved PCM (see Formats.h) straight through the block path: each
+	chunk is deinterleaved and converted into planar scratch with inputGain folded into the
+	conversion, processed, and written back converted with outputGain folded in. Channels 0
+	and 1 are the stereo input and both get the result; any further channels are converted
+	through unchanged. input and output may be the same buffer (in place) when both use the
+	same format; with different formats they must not overlap.
+*/
+		void runInterleaved(const void* input, SampleFormat inputFormat, void* output, SampleFormat outputFormat, size_t numFrames, size_t numChannels,
+			bufferType inputGain = bufferType(1), bufferType outputGain = bufferType(1))
+		{
+			if (numChannels == 0)
+				return;
+			const size_t inputStride = numChannels * bytesPerSample(inputFormat);
+			const size_t outputStride = numChannels * bytesPerSample(outputFormat);
+			const bool passthrough = input != output || inputFormat != outputFormat;
+			for (size_t start = 0; start < numFrames; start += maxSubBlockSize)
+			{
+				const size_t count = numFrames - start < maxSubBlockSize ? numFrames - start : maxSubBlockSize;
+				const uint8_t* in = static_cast<const uint8_t*>(input) + start * inputStride;
+				uint8_t* out = static_cast<uint8_t*>(output) + start * outputStride;
+				const bufferType* right = io[0];
+				Interleaved<bufferType>::read(in, inputFormat, numChannels, 0, count, io[0], inputGain);
+				if (numChannels > 1)
+				{
+					Interleaved<bufferType>::read(in, inputFormat, numChannels, 1, count, io[1], inputGain);
+					right = io[1];
+				}
+				for (size_t channel = 2; channel < numChannels && passthrough; channel++)
+				{
+					Interleaved<bufferType>::read(in, inputFormat, numChannels, channel, count, io[2]);
+					Interleaved<bufferType>::write(io[2], count, out, outputFormat, numChannels, channel);
+				}
+				render(io[0], right, io[0], count);
+				for (size_t channel = 0; channel < numChannels && channel < 2; channel++)
+					Interleaved<bufferType>::write(io[0], count, out, outputFormat, numChannels, channel, outputGain);
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Internal sub-block size of the block path (clamped to 1..maxSubBlockSize);
+	AutoTuner picks the fastest one for the machine at startup
+*/
+		void setSubBlockSize(size_t size)
+		{
+			subBlockSize = size < 1 ? 1 : (size > maxSubBlockSize ? maxSubBlockSize : size);
+		}
+
+		size_t getSubBlockSize() const
+		{
+			return subBlockSize;
+		}
+
+		static constexpr size_t maxSubBlockSize = 256;
+/*===================================================================================*/
+/*
+	[Function] Writes the full DSP state into bytes: the bound control values, the cooked
+	gains and mix, the sidechain envelope, every filter's design and state, the rectifiers,
+	the limiter's delay and gain, branch and tier fades and, in internal-rate mode, the
+	resampler histories and output FIFO. bytes keeps its capacity, so snapshotting into the same vector again does not
+	allocate. A loaded Graph, cabinet Convolver or SpectrumAnalyzer is not part of the
+	snapshot.
+*/
+		void snapshot(std::vector<uint8_t>& bytes) const
+		{
+			StateWriter writer(bytes);
+			writer.write(snapshotMagic);
+			writer.write(snapshotVersion);
+			writer.write(static_cast<uint32_t>(sizeof(bufferType)));
+			const size_t lengthOffset = writer.size();
+			writer.write(uint32_t(0));
+
+			writer.write(internalRate);
+			writer.write(hostRate);
+			writer.write(resampling);
+			writer.write(static_cast<uint32_t>(limiter.getLatencySamples()));
+			writer.write(static_cast<uint32_t>(subBlockSize));
+
+			uint32_t numControls = 0;
+			for (int id = 0; id < maxControlID; id++)
+				numControls += controls.slots && controls.slots[id] >= 0 ? 1 : 0;
+			writer.write(numControls);
+			for (int id = 0; id < maxControlID; id++)
+			{
+				if (controls.slots && controls.slots[id] >= 0)
+				{
+					writer.write(static_cast<int32_t>(id));
+					writer.write(controls.get(id));
+				}
+			}
+
+			gains.save(writer);
+			mix.save(writer);
+			for (const Branch& branch : branches)
+				branch.save(writer);
+			writer.write(tier);
+			writer.write(previousTier);
+			writer.write(tierFade);
+			decimator.save(writer);
+			writer.write(static_cast<uint32_t>(controlInterval));
+			writer.write(static_cast<uint32_t>(controlCountdown));
+			follower.save(writer);
+			writer.write(duck);
+			writer.write(modulated);
+			writer.write(cutoffRatio);
+			writer.write(static_cast<int32_t>(crossoverOrder));
+			crossover.save(writer);
+			limiter.save(writer);
+			lowPass.save(writer);
+			highPass.save(writer);
+			bandPass.save(writer);
+			fullWave.save(writer);
+			reduced.save(writer);
+			minimal.save(writer);
+			if (resampling)
+			{
+				upLeft.save(writer);
+				upRight.save(writer);
+				down.save(writer);
+				writer.write(static_cast<uint32_t>(fifoFill));
+				writer.write(fifo.data(), fifoFill);
+			}
+			writer.overwrite(lengthOffset, static_cast<uint32_t>(writer.size()));
+		}
+/*===================================================================================*/
+/*
+	[Function] Puts a snapshot back in O(state size): no allocation and no filter redesign,
+	so it is fine off the audio thread of a running stream. Control values are written into
+	this instance's bound ControlBlock (skipped if unbound). Fails if the snapshot is from a
+	different build or bufferType, if it was taken in internal-rate mode and this instance
+	isn't reset() for the same host and internal rates, if the limiter lookaheads differ,
+	or if anything in it is out of range. A failed restore leaves this instance (and its
+	controls) as it was: the header is checked before anything changes, and the current
+	state is snapshotted first and put back if the rest fails.
+*/
+		bool restore(const uint8_t* data, size_t size)
+		{
+			StateReader reader(data, size);
+			if (!checkHeader(reader, size))
+				return false;
+			snapshot(rollback);
+			if (restoreBody(reader))
+			{
+				if (graph)
+					graph->setAccuracy(tier == Tier::Full ? Accuracy::High : Accuracy::Low);
+				return true;
+			}
+			StateReader previous(rollback.data(), rollback.size());
+			checkHeader(previous, rollback.size());
+			restoreBody(previous);
+			return false;
+		}
 	private:
 /*===================================================================================*/
 /*
-	[Function] Gets the Control from our nice dandy vector of pointers (DONT MESS WITH IT)
+	[Function] Reads a snapshot's header and checks it fits this instance (changes nothing)
 */
-		effectType getControl(const int& i)
+		bool checkHeader(StateReader& reader, size_t size) const
 		{
-			Parameters* para;
-			for (size_t j = 0; j < _controls.size(); j++)
+			uint32_t magic = 0, version = 0, sampleSize = 0, length = 0;
+			double savedInternalRate = 0.0, savedHostRate = 0.0;
+			bool savedResampling = false;
+			uint32_t savedLookahead = 0;
+			reader.read(magic);
+			reader.read(version);
+			reader.read(sampleSize);
+			reader.read(length);
+			reader.read(savedInternalRate);
+			reader.read(savedHostRate);
+			reader.read(savedResampling);
+			reader.read(savedLookahead);
+			if (!reader.good() || magic != snapshotMagic || version != snapshotVersion || sampleSize != sizeof(bufferType) || length != size)
+				return false;
+			if (savedResampling != resampling || (resampling && (savedInternalRate != internalRate || savedHostRate != hostRate)))
+				return false;
+			return savedLookahead == limiter.getLatencySamples();
+		}
+/*===================================================================================*/
+/*
+	[Function] Everything after the header; false (with the state partly restored) if the
+	rest doesn't parse or is out of range
+*/
+		bool restoreBody(StateReader& reader)
+		{
+			uint32_t savedSubBlockSize = 0, numControls = 0;
+			reader.read(savedSubBlockSize);
+			setSubBlockSize(savedSubBlockSize);
+			reader.read(numControls);
+			for (uint32_t i = 0; i < numControls && reader.good(); i++)
 			{
-				para = &_controls[j];
-				if (para->controlNumber == i)
+				int32_t id = -1;
+				float value = 0.0f;
+				reader.read(id);
+				reader.read(value);
+				controls.set(id, value);
+			}
+
+			gains.restore(reader);
+			mix.restore(reader);
+			for (Branch& branch : branches)
+				branch.restore(reader);
+			reader.read(tier);
+			reader.read(previousTier);
+			reader.read(tierFade);
+			if (!validTier(tier) || !validTier(previousTier))
+				return false;
+			decimator.restore(reader);
+			uint32_t savedInterval = 0, savedCountdown = 0;
+			reader.read(savedInterval);
+			reader.read(savedCountdown);
+			setControlInterval(savedInterval);
+			controlCountdown = savedCountdown < controlInterval ? savedCountdown : controlInterval;
+			follower.restore(reader);
+			reader.read(duck);
+			reader.read(modulated);
+			reader.read(cutoffRatio);
+			int32_t savedOrder = 0;
+			reader.read(savedOrder);
+			crossoverOrder = savedOrder == 2 || savedOrder == 4 ? savedOrder : 0;
+			crossover.restore(reader);
+			if (!limiter.restore(reader))
+				return false;
+			lowPass.restore(reader);
+			highPass.restore(reader);
+			bandPass.restore(reader);
+			fullWave.restore(reader);
+			reduced.restore(reader);
+			minimal.restore(reader);
+			if (resampling)
+			{
+				uint32_t savedFill = 0;
+				if (!upLeft.restore(reader) || !upRight.restore(reader) || !down.restore(reader) || !reader.read(savedFill) || savedFill > fifo.size())
+					return false;
+				fifoFill = savedFill;
+				reader.read(fifo.data(), fifoFill);
+			}
+			return reader.done();
+		}
+
+		static bool validTier(Tier value)
+		{
+			return value == Tier::Full || value == Tier::Reduced || value == Tier::Minimal;
+		}
+/*===================================================================================*/
+/*
+	[Function] The block path proper: result to output, which may alias either input
+*/
+		void render(const bufferType* inputLeft, const bufferType* inputRight, bufferType* output, size_t numSamples)
+		{
+			if (analyzer)
+				analyzer->pushInput(inputLeft, inputRight, numSamples);
+			if (modulating())
+			{
+				// control periods are counted across calls, so the frame and block paths tick alike
+				for (size_t start = 0; start < numSamples;)
 				{
-					if (para->_dataType == boundVariableType::kFloat)
-						return *static_cast<float*>(para->_parameterAddress);
-					if (para->_dataType == boundVariableType::kDouble)
-						return *static_cast<double*>(para->_parameterAddress);
-					if (para->_dataType == boundVariableType::kInt)
-						return *static_cast<int*>(para->_parameterAddress);
-					if (para->_dataType == boundVariableType::kUInt)
-						return *static_cast<uint32_t*>(para->_parameterAddress);
+					if (controlCountdown == 0)
+					{
+						modulate();
+						controlCountdown = controlInterval;
+					}
+					const size_t count = numSamples - start < controlCountdown ? numSamples - start : controlCountdown;
+					follower.accumulate(sidechain[0] ? sidechain[0] + start : nullptr, sidechain[1] ? sidechain[1] + start : nullptr, count);
+					renderMix(inputLeft + start, inputRight + start, output + start, count);
+					controlCountdown -= count;
+					start += count;
 				}
 			}
+			else
+				renderMix(inputLeft, inputRight, output, numSamples);
+			if (convolver)
+				convolver->process(output, numSamples);
+			limit(output, numSamples);
+			if (analyzer)
+				analyzer->pushOutput(output, numSamples);
 		}
 /*===================================================================================*/
 /*
-	[Function] Use this function to Update your meters
+	[Function] The output limiter with the current controls; nothing without a lookahead
 */
-		void setControlValue(const double& newValue,const int& i)
+		void limit(bufferType* output, size_t numSamples)
+		{
+			if (!limiter.isActive())
+				return;
+			limiter.setEnabled(getControl(controlID::limiterSwitch) != effectType(0));
+			limiter.setCeiling(static_cast<double>(getControl(controlID::limiterCeiling)));
+			limiter.setRelease(static_cast<double>(getControl(controlID::limiterRelease)));
+			limiter.process(output, numSamples);
+		}
+/*===================================================================================*/
+/*
+	[Function] The mix at the host rate, resampled or not
+*/
+		void renderMix(const bufferType* inputLeft, const bufferType* inputRight, bufferType* output, size_t numSamples)
+		{
+			if (resampling)
+				renderResampled(inputLeft, inputRight, output, numSamples);
+			else
+				renderNative(inputLeft, inputRight, output, numSamples);
+		}
+/*===================================================================================*/
+/*
+	[Function] Host rate -> internal rate -> DSP -> host rate, maxSubBlockSize host samples
+	at a time. The down side yields a sample more or less than asked for from one chunk to
+	the next, so its output goes through a small FIFO primed with fifoPriming zeros.
+*/
+		void renderResampled(const bufferType* inputLeft, const bufferType* inputRight, bufferType* output, size_t numSamples)
 		{
-			Parameters* para;
-			for (size_t j = 0; j < _controls.size(); j++)
+			for (size_t start = 0; start < numSamples; start += maxSubBlockSize)
 			{
-				para = &_controls[j];
-				if (para->controlNumber == i)
+				const size_t count = numSamples - start < maxSubBlockSize ? numSamples - start : maxSubBlockSize;
+				const size_t internalCount = upLeft.process(inputLeft + start, count, internalLeft.data());
+				upRight.process(inputRight + start, count, internalRight.data());
+				renderNative(internalLeft.data(), internalRight.data(), internalLeft.data(), internalCount);
+				fifoFill += down.process(internalLeft.data(), internalCount, fifo.data() + fifoFill);
+				const size_t available = fifoFill < count ? fifoFill : count;
+				std::memcpy(output + start, fifo.data(), available * sizeof(bufferType));
+				std::memset(output + start + available, 0, (count - available) * sizeof(bufferType));
+				fifoFill -= available;
+				std::memmove(fifo.data(), fifo.data() + available, fifoFill * sizeof(bufferType));
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Sets up the edge resamplers and their buffers (allocates; reset() only)
+*/
+		bool prepareResamplers(double rate)
+		{
+			if (!upLeft.prepare(rate, internalRate) || !upRight.prepare(rate, internalRate) || !down.prepare(internalRate, rate))
+				return false;
+			hostRate = rate;
+			internalLeft.assign(upLeft.maxOutput(maxSubBlockSize), bufferType(0));
+			internalRight.assign(internalLeft.size(), bufferType(0));
+			fifo.assign(fifoPriming + 2 * maxSubBlockSize + 8, bufferType(0));
+			fifoFill = fifoPriming;
+			return true;
+		}
+
+/*===================================================================================*/
+/*
+	[Function] The DSP itself, at the processing rate
+*/
+		void renderNative(const bufferType* inputLeft, const bufferType* inputRight, bufferType* output, size_t numSamples)
+		{
+			if (graph)
+			{
+				graph->update([this](int id) { return getControl(id); });
+				graph->process(inputLeft, inputRight, output, numSamples);
+				return;
+			}
+			cookGains(numSamples);
+			for (size_t start = 0; start < numSamples; start += subBlockSize)
+			{
+				size_t count = numSamples - start < subBlockSize ? numSamples - start : subBlockSize;
+				if (gainRamp.active)
+					rampAt(start);
+				runSubBlock(inputLeft + start, inputRight + start, output + start, count);
+			}
+			if (gainRamp.active)
+				endRamp();
+		}
+		enum BranchIndex { distortion, highPassLeftBranch, highPassRightBranch, clean, numBranches };
+		struct Branch
+		{
+			bool live = true;
+			unsigned fade = 0;
+			void save(StateWriter& writer) const
+			{
+				writer.write(live);
+				writer.write(fade);
+			}
+			bool restore(StateReader& reader)
+			{
+				reader.read(live);
+				return reader.read(fade);
+			}
+		};
+/*===================================================================================*/
+/*
+	[Function] Same signal flow as run(Frame&), one stage at a time over a sub-block
+*/
+		void runSubBlock(const bufferType* left, const bufferType* inputRight, bufferType* output, size_t numSamples)
+		{
+			using namespace Expression;
+			const bufferType* monoLowPass = zeros;
+
+			// while the gains ramp, preGain is applied here rather than in the filters
+			const bufferType* gainedLeft = left;
+			const bufferType* gainedRight = inputRight;
+			if (gainRamp.active)
+			{
+				evaluate(gained[0], numSamples, rampOf(preGainWeight) * signal(left));
+				evaluate(gained[1], numSamples, rampOf(preGainWeight) * signal(inputRight));
+				gainedLeft = gained[0];
+				gainedRight = gained[1];
+			}
+
+			// in crossover mode both bands of the Full tier come from one pass, up front
+			const bool fullInUse = tier == Tier::Full || (tierFade > 0 && previousTier == Tier::Full);
+			if (crossoverOrder != 0 && fullInUse && anyFilterBranchLive())
+				crossover.process(gainedLeft, gainedRight, bands[0], bands[1], bands[2], bands[3], numSamples);
+
+			if (branches[distortion].live)
+			{
+				bufferType* mono = scratch[1];
+				distortionBranch(tier, gainedLeft, gainedRight, mono, numSamples);
+				if (tierFade > 0)
 				{
-					if (para->_dataType == boundVariableType::kFloat)
-						*static_cast<float*>(para->_parameterAddress) = static_cast<float>(newValue);
-					else if (para->_dataType == boundVariableType::kDouble)
-						*static_cast<double*>(para->_parameterAddress) = newValue;
-					else if (para->_dataType == boundVariableType::kInt)
-						*static_cast<int*>(para->_parameterAddress) = static_cast<int>(newValue);
-					else if (para->_dataType == boundVariableType::kUInt)
-						*static_cast<uint32_t*>(para->_parameterAddress) = static_cast<uint32_t>(newValue);
-					break;
+					distortionBranch(previousTier, gainedLeft, gainedRight, scratch[5], numSamples);
+					crossfade(mono, scratch[5], numSamples);
 				}
+				fadeIn(branches[distortion], mono, numSamples);
+				monoLowPass = mono;
+			}
 
-			}		
+			bufferType* highPassSum = scratch[2];
+			highPassBranch(tier, gainedLeft, gainedRight, highPassSum, numSamples);
+			if (tierFade > 0)
+			{
+				highPassBranch(previousTier, gainedLeft, gainedRight, scratch[5], numSamples);
+				crossfade(highPassSum, scratch[5], numSamples);
+			}
+			tierFade = tierFade > numSamples ? tierFade - static_cast<unsigned>(numSamples) : 0;
+
+			/*
+				The mix, with the dry sum fused in (output may alias the inputs: every term is
+				read at the index being written)
+			*/
+			auto wet = signal(highPassSum) + signal(monoLowPass);
+			if (branches[clean].live && gainRamp.active)
+				evaluate(output, numSamples, wet + rampOf(clean) * stereoToMono(signal(left), signal(inputRight)));
+			else if (branches[clean].live)
+				evaluate(output, numSamples, wet + mix.clean * stereoToMono(signal(left), signal(inputRight)));
+			else
+				evaluate(output, numSamples, wet);
+		}
+/*===================================================================================*/
+/*
+	[Function] M = BP(FW(LP(L) + LP(R))) with the given tier's objects, into mono
+	(scratch[0] is used as a temporary). In crossover mode Full takes the low bands.
+*/
+		void distortionBranch(Tier branchTier, const bufferType* left, const bufferType* right, bufferType* mono, size_t numSamples)
+		{
+			using namespace Expression;
+			if (branchTier == Tier::Minimal)
+			{
+				decimatedDistortion(left, right, mono, numSamples);
+				return;
+			}
+			if (branchTier == Tier::Full && crossoverOrder != 0)
+				evaluate(mono, numSamples, stereoToMono(signal(bands[0]), signal(bands[1])));
+			else
+			{
+				Filter<bufferType, effectType>& lp = branchTier == Tier::Full ? lowPass : reduced.lowPass;
+				bufferType* lowPassLeft = scratch[0];
+				lp.process(left, lowPassLeft, numSamples, 0);
+				lp.process(right, mono, numSamples, 1);
+				evaluate(mono, numSamples, stereoToMono(signal(lowPassLeft), signal(mono)));
+			}
+			(branchTier == Tier::Full ? fullWave : reduced.fullWave).process(mono, numSamples, gains.fullWave);
+			if (gainRamp.active)
+				evaluate(mono, numSamples, rampOf(distortion) * signal(mono));
+			(branchTier == Tier::Full ? bandPass : reduced.bandPass).process(mono, numSamples);
+		}
+/*===================================================================================*/
+/*
+	[Function] The distortion branch at half rate: pairs of input samples are summed, run
+	through the Minimal chain (designed at half the rate) and linearly interpolated back up.
+	Summing rather than averaging keeps the level, since FullWave integrates over half as
+	many samples. preGain is applied to the inputs here, not folded into the low pass, so
+	a pair split across two calls is summed with the same gain whether or not the gains
+	ramp in either.
+*/
+		void decimatedDistortion(const bufferType* left, const bufferType* right, bufferType* mono, size_t numSamples)
+		{
+			const bufferType half = bufferType(0.5);
+			const bufferType preGain = gainRamp.active ? bufferType(1) : gains.preGain;
+			for (size_t i = 0; i < numSamples; i++)
+			{
+				if (!decimator.odd)
+				{
+					decimator.left = preGain * left[i];
+					decimator.right = preGain * right[i];
+					mono[i] = decimator.last;
+				}
+				else
+				{
+					bufferType l = minimal.lowPass.process(decimator.left + preGain * left[i], 0);
+					bufferType r = minimal.lowPass.process(decimator.right + preGain * right[i], 1);
+					bufferType rectified = minimal.fullWave.process(l + r, gains.fullWave);
+					if (gainRamp.active)
+						rectified *= gainRamp.first[distortion] + gainRamp.step[distortion] * static_cast<bufferType>(i);
+					bufferType m = minimal.bandPass.process(rectified);
+					mono[i] = half * (decimator.last + m);
+					decimator.last = m;
+				}
+				decimator.odd = !decimator.odd;
+			}
 		}
 
-		struct Parameters
+/*===================================================================================*/
+/*
+	[Function] highPassSum = masterD * (A2 * HP(L) + A1 * HP(R)). Full filters each side
+	(scratch[3] and scratch[4] are temporaries); the cheaper tiers use the linearity of the
+	high pass and filter the weighted sum once, so weight changes are filtered rather than
+	instant and a revived side needs no fade. In crossover mode Full takes the high bands.
+*/
+		void highPassBranch(Tier branchTier, const bufferType* left, const bufferType* right, bufferType* highPassSum, size_t numSamples)
 		{
-			void* _parameterAddress;
-			boundVariableType _dataType;
-			int controlNumber;
+			using namespace Expression;
+			const bool leftLive = branches[highPassLeftBranch].live;
+			const bool rightLive = branches[highPassRightBranch].live;
+			if (branchTier != Tier::Full)
+			{
+				branches[highPassLeftBranch].fade = 0;
+				branches[highPassRightBranch].fade = 0;
+				if (!leftLive && !rightLive)
+				{
+					std::memset(highPassSum, 0, numSamples * sizeof(bufferType));
+					return;
+				}
+				weighHighPass(highPassSum, left, right, numSamples);
+				highPassFor(branchTier).process(highPassSum, numSamples, 0);
+				return;
+			}
+			const bufferType* highPassLeft = zeros;
+			const bufferType* highPassRight = zeros;
+			if (leftLive)
+			{
+				bufferType* band = crossoverOrder != 0 ? bands[2] : scratch[3];
+				if (crossoverOrder == 0)
+					highPass.process(left, band, numSamples, 0);
+				fadeIn(branches[highPassLeftBranch], band, numSamples);
+				highPassLeft = band;
+			}
+			if (rightLive)
+			{
+				bufferType* band = crossoverOrder != 0 ? bands[3] : scratch[4];
+				if (crossoverOrder == 0)
+					highPass.process(right, band, numSamples, 1);
+				fadeIn(branches[highPassRightBranch], band, numSamples);
+				highPassRight = band;
+			}
+			weighHighPass(highPassSum, highPassLeft, highPassRight, numSamples);
+		}
+/*===================================================================================*/
+/*
+	[Function] output = A2' * left + A1' * right with the high pass weights of the mix,
+	ramped while the gains move
+*/
+		void weighHighPass(bufferType* output, const bufferType* left, const bufferType* right, size_t numSamples)
+		{
+			using namespace Expression;
+			if (gainRamp.active)
+				evaluate(output, numSamples, rampOf(highPassLeftBranch) * signal(left) + rampOf(highPassRightBranch) * signal(right));
+			else
+				evaluate(output, numSamples, mix.highPassLeft * signal(left) + mix.highPassRight * signal(right));
+		}
+
+/*===================================================================================*/
+/*
+	[Function] Sidechain modulation is on while a sidechain with a non zero depth is
+	connected, and until the envelope and the filters are back at rest afterwards
+*/
+		bool modulating()
+		{
+			if (modulated || follower.getLevel() > bufferType(0))
+				return true;
+			return sidechain[0] && (getControl(controlID::sidechainCutoff) != effectType(0) || getControl(controlID::sidechainDuck) != effectType(0));
+		}
+/*===================================================================================*/
+/*
+	[Function] Start of a control period: updates the envelope from the last period's
+	sidechain, sets the ducking gain (picked up by cookGains) and redesigns the filters of
+	the tiers in use whose modulated cutoff moved
+*/
+		void modulate()
+		{
+			follower.setTimes(getControl(controlID::sidechainAttack), getControl(controlID::sidechainRelease));
+			const bufferType level = follower.update();
+			const double octaves = static_cast<double>(getControl(controlID::sidechainCutoff)) * static_cast<double>(level);
+			duck = bufferType(1) - static_cast<bufferType>(getControl(controlID::sidechainDuck)) * level;
+			modulated = octaves != 0.0 || duck != bufferType(1);
+			cutoffRatio = std::exp2(octaves);
+			retune();
+		}
+/*===================================================================================*/
+/*
+	[Function] Designs the filters of the tiers in use at the modulated cutoffs, skipping
+	those already there (Filter::designNow, so no cache lock on the audio thread)
+*/
+		void retune()
+		{
+			for (Tier designTier : { tier, previousTier })
+			{
+				if (designTier != tier && tierFade == 0)
+					continue;
+				for (int k = 0; k < 3; k++)
+				{
+					Filter<bufferType, effectType>& filter = designedFilter(static_cast<int>(designTier) * 3 + k);
+					const int* id = designControls[k];
+					const CoefficientKey designKey = filter.keyFor(static_cast<effectType>(getControl(id[0]) * cutoffRatio), getControl(id[1]), getControl(id[2]));
+					if (designKey != filter.key())
+						filter.designNow(designKey);
+				}
+			}
+		}
+
+/*===================================================================================*/
+/*
+	[Function] Filter i of Designs: low, high and band pass of Full, Reduced, then Minimal
+*/
+		Filter<bufferType, effectType>& designedFilter(int i)
+		{
+			Filter<bufferType, effectType>* filters[3][3] = {
+				{ &lowPass, &highPass, &bandPass },
+				{ &reduced.lowPass, &reduced.highPass, &reduced.bandPass },
+				{ &minimal.lowPass, &minimal.highPass, &minimal.bandPass }
+			};
+			return *filters[i / 3][i % 3];
+		}
+
+		Filter<bufferType, effectType>& highPassFor(Tier branchTier)
+		{
+			return branchTier == Tier::Full ? highPass : (branchTier == Tier::Reduced ? reduced.highPass : minimal.highPass);
+		}
+
+		void clearDistortion(Tier branchTier)
+		{
+			if (branchTier == Tier::Full)
+			{
+				lowPass.clearState();
+				bandPass.clearState();
+				fullWave.reset();
+				return;
+			}
+			Chain& chain = branchTier == Tier::Reduced ? reduced : minimal;
+			chain.lowPass.clearState();
+			chain.bandPass.clearState();
+			chain.fullWave.reset();
+			if (branchTier == Tier::Minimal)
+				decimator = Decimator();
+		}
+/*===================================================================================*/
+/*
+	[Function] output = old -> output over what is left of the tier fade
+*/
+		void crossfade(bufferType* output, const bufferType* old, size_t numSamples)
+		{
+			for (size_t i = 0; i < numSamples && i < tierFade; i++)
+			{
+				bufferType ramp = bufferType(tierFadeLength - (tierFade - i)) / bufferType(tierFadeLength);
+				output[i] = old[i] + ramp * (output[i] - old[i]);
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Block rate branch liveness. A branch whose weight is exactly zero contributes
+	exactly nothing, so its filters are not run at all (a clean-only instance only sums the
+	dry input). Their state is frozen meanwhile; when the branch comes back it starts from
+	cleared state and fades in over fadeLength samples instead of replaying stale history.
+*/
+		void updateBranches()
+		{
+			bufferType weights[numWeights];
+			weightsOf(gains, weights);
+			const bool highPassWasDead = !branches[highPassLeftBranch].live && !branches[highPassRightBranch].live;
+			const bool filtersWereDead = !anyFilterBranchLive();
+			for (int i = 0; i < numBranches; i++)
+			{
+				// a branch ramping to zero stays live until the end of the ramp
+				bool live = weights[i] != bufferType(0) || (gainRamp.active && gainRamp.from[i] != bufferType(0));
+				if (live && !branches[i].live)
+				{
+					for (Tier branchTier : { tier, previousTier })
+					{
+						if (i == distortion)
+							clearDistortion(branchTier);
+						else if (branchTier == Tier::Full)
+							highPass.clearState(i == highPassLeftBranch ? 0 : 1);
+						else if (highPassWasDead)
+							highPassFor(branchTier).clearState();
+					}
+					branches[i].fade = i == clean ? 0 : fadeLength;
+				}
+				branches[i].live = live;
+			}
+			// the crossover feeds all three filtered branches, so it restarts only when all were off
+			if (filtersWereDead && anyFilterBranchLive())
+				crossover.clearState();
+		}
+
+		bool anyFilterBranchLive() const
+		{
+			return branches[distortion].live || branches[highPassLeftBranch].live || branches[highPassRightBranch].live;
+		}
+
+		bufferType fadeIn(Branch& branch, const bufferType& value)
+		{
+			if (branch.fade == 0)
+				return value;
+			bufferType ramp = bufferType(fadeLength - branch.fade) / bufferType(fadeLength);
+			branch.fade--;
+			return ramp * value;
+		}
+
+		void fadeIn(Branch& branch, bufferType* buffer, size_t numSamples)
+		{
+			for (size_t i = 0; i < numSamples && branch.fade > 0; i++)
+				buffer[i] = fadeIn(branch, buffer[i]);
+		}
+/*===================================================================================*/
+/*
+	[Function] Converts the gain controls to bufferType once, outside the sample loops, and
+	recompiles the mix if any of them moved. The block path passes the samples to come, and
+	gains that moved then ramp across them (startRamp) instead of stepping.
+*/
+		void cookGains(size_t rampLength = 1)
+		{
+			Gains cooked;
+			cooked.preGain = static_cast<bufferType>(getControl(controlID::preGain));
+			cooked.A1 = static_cast<bufferType>(getControl(controlID::A1));
+			cooked.A2 = static_cast<bufferType>(getControl(controlID::A2));
+			cooked.masterD = static_cast<bufferType>(getControl(controlID::masterD)) * duck;
+			cooked.masterC = static_cast<bufferType>(getControl(controlID::masterC));
+			cooked.fullWave = getControl(controlID::fullWaveSwitch) != effectType(0);
+			bool changed = cooked.preGain != gains.preGain || cooked.A1 != gains.A1 || cooked.A2 != gains.A2 ||
+				cooked.masterD != gains.masterD || cooked.masterC != gains.masterC;
+			const Gains previous = gains;
+			gains = cooked;
+			if (changed && mix.compiled && rampLength > 1)
+				startRamp(previous, rampLength);
+			else if (changed || !mix.compiled)
+				compileMix();
+			updateBranches();
+			updateCrossover();
+		}
+/*===================================================================================*/
+/*
+	[Function] Crossover control: OFF keeps the separate low and high pass, LR2 / LR4 split
+	at the low pass cutoff (LPF_FC, moved by the sidechain like the filters) and HPF_FC is
+	then unused. On a switch, the filters taking over start from cleared state rather than
+	from stale history.
+*/
+		void updateCrossover()
+		{
+			const effectType mode = getControl(controlID::crossoverMode);
+			const int order = mode >= effectType(1.5) ? 4 : (mode >= effectType(0.5) ? 2 : 0);
+			if (order != crossoverOrder)
+			{
+				if (order != 0)
+				{
+					crossover.setOrder(order);
+					crossover.clearState();
+				}
+				else
+				{
+					lowPass.clearState();
+					highPass.clearState();
+				}
+				crossoverOrder = order;
+			}
+			if (crossoverOrder != 0)
+				crossover.setFrequency(static_cast<double>(getControl(controlID::lowPassFC)) * cutoffRatio);
+		}
+/*===================================================================================*/
+/*
+	[Function] Reduces the output expression
+
+		masterD * (A1 * (HPR + M) + A2 * (M + HPL)) + masterC * (L + R),  M = BP(FW(LP(g L) + LP(g R)))
+
+	to
+
+		HPL' * masterD * A2  +  HPR' * masterD * A1  +  M'  +  (L + R) * masterC
+
+	where the primes mean preGain is folded into the low and high pass numerators (the
+	crossover's input gain in crossover mode) and
+	masterD * (A1 + A2) into the band pass numerator. Folding preGain through FullWave is
+	exact because FullWave is positively homogeneous and preGain >= 0. While the gains ramp
+	the filters get unit gains and runSubBlock applies both per sample instead.
+*/
+		void compileMix()
+		{
+			const bufferType preGain = gainRamp.active ? bufferType(1) : gains.preGain;
+			const bufferType bandPassGain = gainRamp.active ? bufferType(1) : gains.masterD * (gains.A1 + gains.A2);
+			lowPass.setGain(preGain);
+			highPass.setGain(preGain);
+			crossover.setGain(preGain);
+			bandPass.setGain(bandPassGain);
+			reduced.setGain(preGain, bandPassGain);
+			minimal.setGain(preGain, bandPassGain);
+			minimal.lowPass.setGain(bufferType(1));		// decimatedDistortion applies preGain
+			mix.highPassLeft = gains.masterD * gains.A2;
+			mix.highPassRight = gains.masterD * gains.A1;
+			mix.clean = gains.masterC;
+			mix.compiled = true;
+		}
+/*===================================================================================*/
+/*
+	[Function] Gets the Control by controlID from the bound ControlBlock (DONT MESS WITH IT)
+*/
+		effectType getControl(const int& i)
+		{
+			return static_cast<effectType>(controls.get(i));
+		}
+/*===================================================================================*/
+/*
+	[Function] Use this function to Update your meters
+*/
+		void setControlValue(const double& newValue,const int& i)
+		{
+			controls.set(i, static_cast<float>(newValue));
+		}
+
+		ControlBlock controls;
+
+		struct Gains
+		{
+			bufferType preGain = 0;
+			bufferType A1 = 0;
+			bufferType A2 = 0;
+			bufferType masterD = 0;
+			bufferType masterC = 0;
+			bool fullWave = false;
+			void save(StateWriter& writer) const
+			{
+				const bufferType values[5] = { preGain, A1, A2, masterD, masterC };
+				writer.write(values, 5);
+				writer.write(fullWave);
+			}
+			bool restore(StateReader& reader)
+			{
+				bufferType values[5] = {};
+				reader.read(values, 5);
+				reader.read(fullWave);
+				preGain = values[0];
+				A1 = values[1];
+				A2 = values[2];
+				masterD = values[3];
+				masterC = values[4];
+				return reader.good();
+			}
+		};
+		Gains gains;
+
+		struct Mix
+		{
+			bufferType highPassLeft = 0;
+			bufferType highPassRight = 0;
+			bufferType clean = 0;
+			bool compiled = false;
+			void save(StateWriter& writer) const
+			{
+				const bufferType values[3] = { highPassLeft, highPassRight, clean };
+				writer.write(values, 3);
+				writer.write(compiled);
+			}
+			bool restore(StateReader& reader)
+			{
+				bufferType values[3] = {};
+				reader.read(values, 3);
+				reader.read(compiled);
+				highPassLeft = values[0];
+				highPassRight = values[1];
+				clean = values[2];
+				return reader.good();
+			}
+		};
+		Mix mix;
+
+		static constexpr int preGainWeight = numBranches;
+		static constexpr int numWeights = numBranches + 1;
+		struct GainRamp
+		{
+			bool active = false;
+			bufferType from[numWeights] = {};
+			bufferType step[numWeights] = {};
+			bufferType first[numWeights] = {};		// at the current sub-block's first sample
 		};
-		std::vector<Parameters> _controls;
+		GainRamp gainRamp;
+/*===================================================================================*/
+/*
+	[Function] The branch weights (indexed like branches) and preGain of a set of gains
+*/
+		static void weightsOf(const Gains& from, bufferType* weights)
+		{
+			weights[distortion] = from.masterD * (from.A1 + from.A2);
+			weights[highPassLeftBranch] = from.masterD * from.A2;
+			weights[highPassRightBranch] = from.masterD * from.A1;
+			weights[clean] = from.masterC;
+			weights[preGainWeight] = from.preGain;
+		}
+/*===================================================================================*/
+/*
+	[Function] Gains that moved since the last call ramp linearly across this call's
+	numSamples, reaching the new values on its last sample, instead of stepping at its
+	start. For the call the filters hold unit gains and preGain and the weights are applied
+	per sample; a numerator gain is exactly a gain on the filter's input, so switching to
+	that form and back (endRamp) leaves the filter states valid.
+*/
+		void startRamp(const Gains& previous, size_t numSamples)
+		{
+			bufferType to[numWeights];
+			weightsOf(previous, gainRamp.from);
+			weightsOf(gains, to);
+			for (int i = 0; i < numWeights; i++)
+				gainRamp.step[i] = (to[i] - gainRamp.from[i]) / static_cast<bufferType>(numSamples);
+			gainRamp.active = true;
+			compileMix();
+		}
+
+		void rampAt(size_t start)
+		{
+			for (int i = 0; i < numWeights; i++)
+				gainRamp.first[i] = gainRamp.from[i] + gainRamp.step[i] * static_cast<bufferType>(start + 1);
+		}
+
+		void endRamp()
+		{
+			gainRamp.active = false;
+			compileMix();
+		}
+
+		Expression::Ramp<bufferType> rampOf(int weight) const
+		{
+			return Expression::ramp(gainRamp.first[weight], gainRamp.step[weight]);
+		}
+
+		Branch branches[numBranches];
+		static constexpr unsigned fadeLength = 64;
+
+		Filter<bufferType, effectType> lowPass;
+		Filter<bufferType, effectType> highPass;
+		Filter<bufferType, effectType> bandPass;
+		FullWave<bufferType> fullWave;
+		Crossover<bufferType> crossover;
+		int crossoverOrder = 0;		// 0 while the separate low and high pass are in use
+/*===================================================================================*/
+/*
+	[Struct] Objects of the cheaper tiers (Full uses the members above)
+*/
+		struct Chain
+		{
+			Chain()
+			{
+				lowPass.setFilterType(filterAlgorithm::kButterLPF2);
+				highPass.setFilterType(filterAlgorithm::kButterHPF2);
+				bandPass.setFilterType(filterAlgorithm::kBPF2);
+			}
+			void setSampleRate(double rate, double distortionRate)
+			{
+				lowPass.setSampleRate(distortionRate);
+				highPass.setSampleRate(rate);
+				bandPass.setSampleRate(distortionRate);
+			}
+			void reset(double rate, double distortionRate)
+			{
+				lowPass.reset(distortionRate);
+				highPass.reset(rate);
+				bandPass.reset(distortionRate);
+				fullWave.reset();
+			}
+			void setGain(bufferType preGain, bufferType bandPassGain)
+			{
+				lowPass.setGain(preGain);
+				highPass.setGain(preGain);
+				bandPass.setGain(bandPassGain);
+			}
+			void save(StateWriter& writer) const
+			{
+				lowPass.save(writer);
+				highPass.save(writer);
+				bandPass.save(writer);
+				fullWave.save(writer);
+			}
+			bool restore(StateReader& reader)
+			{
+				lowPass.restore(reader);
+				highPass.restore(reader);
+				bandPass.restore(reader);
+				return fullWave.restore(reader);
+			}
+			Filter<bufferType, effectType> lowPass;
+			Filter<bufferType, effectType> highPass;
+			Filter<bufferType, effectType> bandPass;
+			FullWave<bufferType> fullWave;
+		};
+		Chain reduced;
+		Chain minimal;
 
-		Filter<float, float> lowPass;
-		Filter<float, float> highPass;
-		Filter<float, float> bandPass;
-		FullWave<float> fullWave;
+		struct Decimator
+		{
+			bufferType left = 0;
+			bufferType right = 0;
+			bufferType last = 0;
+			bool odd = false;
+			void save(StateWriter& writer) const
+			{
+				const bufferType values[3] = { left, right, last };
+				writer.write(values, 3);
+				writer.write(odd);
+			}
+			bool restore(StateReader& reader)
+			{
+				bufferType values[3] = {};
+				reader.read(values, 3);
+				reader.read(odd);
+				left = values[0];
+				right = values[1];
+				last = values[2];
+				return reader.good();
+			}
+		};
+		Decimator decimator;
+
+		Tier tier = Tier::Full;
+		Tier previousTier = Tier::Full;
+		unsigned tierFade = 0;
+		static constexpr unsigned tierFadeLength = 256;
+
+		size_t subBlockSize = 64;
+		Graph<bufferType, effectType>* graph = nullptr;
+		Convolver<bufferType>* convolver = nullptr;
+		SpectrumAnalyzer* analyzer = nullptr;
+		Limiter<bufferType> limiter;
+
+		static constexpr int designControls[3][3] = {
+			{ controlID::lowPassFC, controlID::lowPass_Q, controlID::lpfBoost },
+			{ controlID::highPassFC, controlID::highPassQ, controlID::hpfBoost },
+			{ controlID::bandPassFC, controlID::bandPassQ, controlID::bandPassBoost }
+		};
+		EnvelopeFollower<bufferType> follower;
+		const bufferType* sidechain[2] = { nullptr, nullptr };
+		bufferType duck = 1;
+		bool modulated = false;
+		double cutoffRatio = 1.0;
+		size_t controlInterval = 32;
+		size_t controlCountdown = 0;
+		bufferType scratch[6][maxSubBlockSize];
+		bufferType io[3][maxSubBlockSize];
+		bufferType gained[2][maxSubBlockSize];		// the inputs with ramping preGain applied
+		bufferType zeros[maxSubBlockSize] = {};
+		bufferType bands[4][maxSubBlockSize];	// crossover low left, low right, high left, high right
+
+		double internalRate = 0.0;
+		double hostRate = 44100.0;
+		bool resampling = false;
+		Resampler<bufferType> upLeft;
+		Resampler<bufferType> upRight;
+		Resampler<bufferType> down;
+		std::vector<bufferType> internalLeft;
+		std::vector<bufferType> internalRight;
+		std::vector<bufferType> fifo;
+		size_t fifoFill = 0;
+		static constexpr size_t fifoPriming = 4;
+
+		static constexpr uint32_t snapshotMagic = 0x4E535841;	// "AXSN"
+		static constexpr uint32_t snapshotVersion = 5;
+		std::vector<uint8_t> rollback;		// restore()'s copy of the state it replaces
 	};
 
+/*===================================================================================*/
+/*
+	[Aliases] Precision policy: float32 end to end in production, float64 as the reference
+	to measure it against. Controls, coefficients and state all follow bufferType. The
+	float output stays within 5e-5 of the reference's peak (tests/precision_test.cpp).
+*/
+	using ProductionEffect = Effect<float, float>;
+	using ReferenceEffect = Effect<double, double>;
+
 
 
 
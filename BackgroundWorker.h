@@ -0,0 +1,133 @@
+#pragma once
+#ifndef AuxPort_BackgroundWorker_H
+#define AuxPort_BackgroundWorker_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Anything that wants work done off the audio thread. requestService() is a single
+	atomic store, so it is safe to call from the audio callback; service() then runs on the
+	shared worker thread within BackgroundWorker::pollIntervalMs.
+*/
+/*===================================================================================*/
+	class BackgroundTask
+	{
+	public:
+		BackgroundTask() = default;
+		BackgroundTask(const BackgroundTask&) = delete;
+		virtual ~BackgroundTask() = default;
+		virtual void service() = 0;
+		void requestService()
+		{
+			serviceRequested.store(true, std::memory_order_release);
+		}
+	private:
+		friend class BackgroundWorker;
+		std::atomic<bool> serviceRequested{ false };
+	};
+
+/*===================================================================================*/
+/*
+	[Class] One worker thread per process shared by every plugin instance. The thread is
+	started by the first attach() and joined by the last detach(), so it never outlives the
+	instances that use it.
+*/
+/*===================================================================================*/
+	class BackgroundWorker
+	{
+	public:
+		static BackgroundWorker& get()
+		{
+			static BackgroundWorker worker;
+			return worker;
+		}
+/*===================================================================================*/
+/*
+	[Function] Registers / unregisters a task (never from the audio thread). detach() waits
+	for a service() call in progress, so the task can be destroyed right after.
+*/
+		void attach(BackgroundTask* task)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(task);
+			if (!thread.joinable())
+			{
+				running = true;
+				thread = std::thread([this]() { loop(); });
+			}
+		}
+
+		void detach(BackgroundTask* task)
+		{
+			std::thread finished;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.erase(std::remove(tasks.begin(), tasks.end(), task), tasks.end());
+				if (tasks.empty() && thread.joinable())
+				{
+					running = false;
+					finished = std::move(thread);
+				}
+			}
+			if (finished.joinable())
+			{
+				wakeUp.notify_all();
+				finished.join();
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Runs pending requests now instead of at the next poll (not for the audio thread)
+*/
+		void wake()
+		{
+			wakeUp.notify_all();
+		}
+
+		std::atomic<unsigned> pollIntervalMs{ 5 };
+	private:
+		BackgroundWorker() = default;
+		~BackgroundWorker()
+		{
+			std::thread finished;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				running = false;
+				finished = std::move(thread);
+			}
+			if (finished.joinable())
+			{
+				wakeUp.notify_all();
+				finished.join();
+			}
+		}
+
+		void loop()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (running)
+			{
+				for (size_t i = 0; i < tasks.size(); i++)
+				{
+					if (tasks[i]->serviceRequested.exchange(false, std::memory_order_acq_rel))
+						tasks[i]->service();
+				}
+				wakeUp.wait_for(lock, std::chrono::milliseconds(pollIntervalMs.load()));
+			}
+		}
+
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::vector<BackgroundTask*> tasks;
+		std::thread thread;
+		bool running = false;
+	};
+}
+#endif
@@ -0,0 +1,382 @@
+#ifndef AuxPort_BatchRender_H
+#define AuxPort_BatchRender_H
+#pragma once
+/*
+*			AuxPort Batch Renderer
+			Offline rendering of whole folders / manifests of files through the Effect kernel.
+			See LICENSE in the repository root.
+*/
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "plugincore.h"
+#include "Formats.h"
+#include "WaveFile.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Struct] One full set of plugin controls, in parameterTable slot order, starting at the
+	PluginParameter defaults
+*/
+	struct EffectSettings
+	{
+		EffectSettings()
+		{
+			parameterTable.setDefaults(values);
+		}
+/*===================================================================================*/
+/*
+	[Function] Points the kernel's controls at this object (call once per kernel)
+*/
+		template<class bufferType, class effectType>
+		void bind(Effect<bufferType, effectType>& kernel)
+		{
+			kernel.bind({ values, parameterTable.slotMap() });
+		}
+/*===================================================================================*/
+/*
+	[Function] Sets a control by its PluginParameter name (e.g. "LPF_FC"), false if unknown.
+	Discrete controls take the string's index, rounded and clamped to the list.
+*/
+		bool set(const std::string& name, double value)
+		{
+			int slot = parameterTable.slotOf(name.c_str());
+			if (slot < 0)
+				return false;
+			if (parameterTable[slot].type == controlVariableType::kTypedEnumStringList)
+			{
+				// --- the index of one of the control's strings
+				const double last = static_cast<double>(parameterTable[slot].stringCount() - 1);
+				value = std::round(value);
+				value = !(value > 0.0) ? 0.0 : (value > last ? last : value);
+			}
+			values[slot] = static_cast<float>(value);
+			return true;
+		}
+
+		float values[parameterTable.size()];
+	};
+
+/*===================================================================================*/
+/*
+	[Struct] One file to render; the output path doubles as the job's key in the journal
+*/
+	struct BatchJob
+	{
+		std::string input;
+		std::string output;
+		EffectSettings settings;
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Renders jobs across a pool of workers that each keep one prepared Effect alive
+
+	- jobs already listed in the journal are skipped, so a crashed run can simply be restarted
+	- outputs are written to "<output>.part" and renamed once complete, then journaled
+	- progress and throughput are rewritten to the stats file about once a second
+*/
+/*===================================================================================*/
+	class BatchRenderer
+	{
+	public:
+		BatchRenderer(const std::string& journalPath, const std::string& statsPath, unsigned numWorkers = 0)
+			: journalPath(journalPath), statsPath(statsPath)
+		{
+			if (numWorkers == 0)
+				numWorkers = std::thread::hardware_concurrency();
+			if (numWorkers == 0)
+				numWorkers = 1;
+			for (unsigned i = 0; i < numWorkers; i++)
+			{
+				workers.emplace_back(new Worker());
+				workers.back()->settings.bind(workers.back()->kernel);
+			}
+			loadJournal();
+		}
+		BatchRenderer(const BatchRenderer&) = delete;
+		~BatchRenderer() = default;
+/*===================================================================================*/
+/*
+	[Function] Reads a manifest: one job per line, "input output [ParameterName=value ...]"
+	Blank lines and lines starting with '#' are ignored. Returns false on a malformed line.
+*/
+		static bool readManifest(const std::string& path, std::vector<BatchJob>& jobs, std::string& error)
+		{
+			std::ifstream file(path);
+			if (!file)
+			{
+				error = "cannot open manifest " + path;
+				return false;
+			}
+			std::string line;
+			size_t lineNumber = 0;
+			while (std::getline(file, line))
+			{
+				lineNumber++;
+				std::istringstream fields(line);
+				BatchJob job;
+				if (!(fields >> job.input) || job.input[0] == '#')
+					continue;
+				if (!(fields >> job.output))
+				{
+					error = path + ":" + std::to_string(lineNumber) + ": missing output path";
+					return false;
+				}
+				std::string assignment;
+				while (fields >> assignment)
+				{
+					size_t equals = assignment.find('=');
+					if (equals == std::string::npos || !job.settings.set(assignment.substr(0, equals), std::atof(assignment.c_str() + equals + 1)))
+					{
+						error = path + ":" + std::to_string(lineNumber) + ": bad parameter '" + assignment + "'";
+						return false;
+					}
+				}
+				jobs.push_back(job);
+			}
+			return true;
+		}
+/*===================================================================================*/
+/*
+	[Function] Renders every job that is not journaled yet; returns the number of failures
+*/
+		size_t run(const std::vector<BatchJob>& jobs)
+		{
+			std::vector<const BatchJob*> pending;
+			for (const BatchJob& job : jobs)
+			{
+				if (done.count(job.output) == 0)
+					pending.push_back(&job);
+			}
+			stats.total += jobs.size();
+			stats.skipped += jobs.size() - pending.size();
+			std::atomic<size_t> next{ 0 };
+			std::atomic<size_t> failures{ 0 };
+			bool finished = false;
+			std::mutex reporterMutex;
+			std::condition_variable reporterWake;
+
+			std::vector<std::thread> threads;
+			for (auto& worker : workers)
+			{
+				Worker* w = worker.get();
+				threads.emplace_back([&, w]()
+				{
+					size_t index;
+					while ((index = next.fetch_add(1)) < pending.size())
+					{
+						if (!render(*w, *pending[index]))
+							failures++;
+					}
+				});
+			}
+			std::thread reporter([&]()
+			{
+				std::unique_lock<std::mutex> lock(reporterMutex);
+				while (!finished)
+				{
+					writeStats();
+					reporterWake.wait_for(lock, std::chrono::milliseconds(statsIntervalMs));
+				}
+			});
+			for (auto& thread : threads)
+				thread.join();
+			{
+				std::lock_guard<std::mutex> lock(reporterMutex);
+				finished = true;
+			}
+			reporterWake.notify_one();
+			reporter.join();
+			writeStats();
+			return failures.load();
+		}
+/*===================================================================================*/
+/*
+	[Function] Watches a directory and renders every new .wav file into outputDirectory with
+	the given settings. A file is only picked up once its size and modification time are
+	the same on two polls in a row, so one still being copied in is left alone. Runs until
+	stop becomes true (or the folder has been idle for idleExitMs, when that is non-zero).
+*/
+		void watch(const std::string& inputDirectory, const std::string& outputDirectory, const EffectSettings& settings,
+			const std::atomic<bool>& stop, unsigned pollMs = 1000, unsigned idleExitMs = 0)
+		{
+			namespace fs = std::filesystem;
+			auto lastWork = std::chrono::steady_clock::now();
+			std::unordered_map<std::string, std::pair<uintmax_t, fs::file_time_type>> growing;	// size and time at the last poll
+			while (!stop.load())
+			{
+				std::vector<BatchJob> jobs;
+				bool changing = false;
+				std::error_code ec;
+				for (const fs::directory_entry& entry : fs::directory_iterator(inputDirectory, ec))
+				{
+					if (!entry.is_regular_file() || entry.path().extension() != ".wav")
+						continue;
+					BatchJob job{ entry.path().string(), (fs::path(outputDirectory) / entry.path().filename()).string(), settings };
+					if (done.count(job.output) != 0 || failed.count(job.output) != 0)
+						continue;
+					std::error_code sizeError, timeError;
+					const uintmax_t size = entry.file_size(sizeError);
+					const fs::file_time_type time = entry.last_write_time(timeError);
+					if (sizeError || timeError)
+						continue;
+					auto last = growing.find(job.input);
+					if (last != growing.end() && last->second.first == size && last->second.second == time)
+					{
+						growing.erase(last);
+						jobs.push_back(job);
+					}
+					else
+					{
+						growing[job.input] = { size, time };
+						changing = true;
+					}
+				}
+				if (changing)
+					lastWork = std::chrono::steady_clock::now();
+				if (!jobs.empty())
+				{
+					run(jobs);
+					lastWork = std::chrono::steady_clock::now();
+				}
+				else if (idleExitMs != 0 && std::chrono::steady_clock::now() - lastWork > std::chrono::milliseconds(idleExitMs))
+					break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+			}
+		}
+		unsigned statsIntervalMs = 1000;
+		size_t framesPerChunk = 4096;
+	private:
+		struct Worker
+		{
+			EffectSettings settings;
+			ProductionEffect kernel;
+		};
+		struct Stats
+		{
+			std::atomic<size_t> total{ 0 };
+			std::atomic<size_t> skipped{ 0 };
+			std::atomic<size_t> completed{ 0 };
+			std::atomic<size_t> failed{ 0 };
+			std::atomic<uint64_t> frames{ 0 };
+			std::atomic<uint64_t> audioMicroseconds{ 0 };
+			std::atomic<uint64_t> renderMicroseconds{ 0 };
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		};
+
+		bool render(Worker& worker, const BatchJob& job)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			WaveFile audio;
+			if (!audio.read(job.input) || audio.channels == 0)
+				return fail(job);
+
+			worker.settings = job.settings;
+			worker.kernel.reset(static_cast<float>(audio.sampleRate));
+			worker.kernel.prepareToPlay(static_cast<float>(audio.sampleRate));
+
+			const size_t channels = audio.channels;
+			const size_t frames = audio.frames();
+			for (size_t start = 0; start < frames; start += framesPerChunk)
+			{
+				size_t end = std::min(frames, start + framesPerChunk);
+				float* chunk = audio.samples.data() + start * channels;
+				worker.kernel.runInterleaved(chunk, SampleFormat::Float32, chunk, SampleFormat::Float32, end - start, channels);
+				stats.frames += end - start;
+			}
+
+			std::string part = job.output + ".part";
+			std::error_code ec;
+			if (!audio.write(part))
+				return fail(job);
+			std::filesystem::rename(part, job.output, ec);
+			if (ec)
+				return fail(job);
+
+			journal(job.output);
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+			stats.renderMicroseconds += static_cast<uint64_t>(elapsed.count());
+			stats.audioMicroseconds += static_cast<uint64_t>(frames * 1000000.0 / audio.sampleRate);
+			stats.completed++;
+			return true;
+		}
+
+		bool fail(const BatchJob& job)
+		{
+			std::lock_guard<std::mutex> lock(journalMutex);
+			failed.insert(job.output);
+			stats.failed++;
+			return false;
+		}
+
+		void loadJournal()
+		{
+			std::ifstream file(journalPath);
+			std::string line;
+			while (std::getline(file, line))
+			{
+				if (line.compare(0, 5, "done\t") == 0)
+					done.insert(line.substr(5));
+			}
+		}
+
+		void journal(const std::string& output)
+		{
+			std::lock_guard<std::mutex> lock(journalMutex);
+			done.insert(output);
+			std::ofstream file(journalPath, std::ios::app);
+			file << "done\t" << output << "\n";
+			file.flush();
+		}
+
+		void writeStats()
+		{
+			double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - stats.start).count();
+			double audioSeconds = stats.audioMicroseconds.load() * 1e-6;
+			size_t finished = stats.completed.load() + stats.failed.load() + stats.skipped.load();
+			std::string part = statsPath + ".part";
+			{
+				std::ofstream file(part, std::ios::trunc);
+				file << "jobs_total " << stats.total.load() << "\n"
+					<< "jobs_completed " << stats.completed.load() << "\n"
+					<< "jobs_skipped " << stats.skipped.load() << "\n"
+					<< "jobs_failed " << stats.failed.load() << "\n"
+					<< "progress " << (stats.total.load() ? static_cast<double>(finished) / stats.total.load() : 1.0) << "\n"
+					<< "workers " << workers.size() << "\n"
+					<< "frames " << stats.frames.load() << "\n"
+					<< "wall_seconds " << wall << "\n"
+					<< "audio_seconds " << audioSeconds << "\n"
+					<< "render_seconds " << stats.renderMicroseconds.load() * 1e-6 << "\n"
+					<< "frames_per_second " << (wall > 0 ? stats.frames.load() / wall : 0.0) << "\n"
+					<< "realtime_factor " << (wall > 0 ? audioSeconds / wall : 0.0) << "\n";
+			}
+			std::error_code ec;
+			std::filesystem::rename(part, statsPath, ec);
+		}
+
+		std::string journalPath;
+		std::string statsPath;
+		std::vector<std::unique_ptr<Worker>> workers;
+		std::unordered_set<std::string> done;
+		std::unordered_set<std::string> failed;
+		std::mutex journalMutex;
+		Stats stats;
+	};
+}
+#endif
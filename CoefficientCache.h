@@ -0,0 +1,205 @@
+#pragma once
+#ifndef AuxPort_CoefficientCache_H
+#define AuxPort_CoefficientCache_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Struct] What a biquad design depends on. Compared bit for bit, so any change in a
+	parameter is a different key.
+*/
+/*===================================================================================*/
+	struct CoefficientKey
+	{
+		int32_t algorithm = 0;
+		double fc = 0.0;
+		double Q = 0.0;
+		double boostCut = 0.0;
+		double sampleRate = 0.0;
+
+		bool operator==(const CoefficientKey& other) const
+		{
+			return algorithm == other.algorithm && std::memcmp(&fc, &other.fc, sizeof(double)) == 0 && std::memcmp(&Q, &other.Q, sizeof(double)) == 0 &&
+				std::memcmp(&boostCut, &other.boostCut, sizeof(double)) == 0 && std::memcmp(&sampleRate, &other.sampleRate, sizeof(double)) == 0;
+		}
+
+		bool operator!=(const CoefficientKey& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Process wide coefficient cache
+
+	Filters with the same key share one design, so a preset change across a session
+	designs each unique setting once. The cache is numSets sets of numWays entries; a key
+	hashes to one set and, when the set is full, replaces its least recently used entry.
+	Each entry is guarded by a sequence counter instead of a lock or a reference count:
+	a lookup copies the key and coefficients and then checks the counter didn't move, so
+	it is lock free and writes nothing shared on a hit (an entry recycled under a reader
+	is just a miss). Only inserting a new design takes the mutex. Callers copy the five
+	coefficients out, so nothing ever holds on to an entry.
+*/
+/*===================================================================================*/
+	class CoefficientCache
+	{
+	public:
+		using Designer = void(*)(const CoefficientKey& key, double* coefficients);
+		static constexpr size_t numSets = 128;
+		static constexpr size_t numWays = 8;
+
+		static CoefficientCache& shared()
+		{
+			static CoefficientCache cache;
+			return cache;
+		}
+
+		CoefficientCache(const CoefficientCache&) = delete;
+		CoefficientCache& operator=(const CoefficientCache&) = delete;
+/*===================================================================================*/
+/*
+	[Function] Cached coefficients (a0, a1, a2, b1, b2) for key; on a miss they are designed
+	with designer (outside the lock) and inserted
+*/
+		void design(const CoefficientKey& key, Designer designer, double* coefficients)
+		{
+			uint64_t words[keyWords];
+			pack(key, words);
+			Entry* set = entries + (hash(words) % numSets) * numWays;
+			if (find(set, words, coefficients))
+				return;
+			designer(key, coefficients);
+			misses.fetch_add(1, std::memory_order_relaxed);
+			std::lock_guard<std::mutex> lock(mutex);
+			double existing[5];
+			if (find(set, words, existing))
+				return;
+			Entry* victim = set;
+			for (size_t way = 0; way < numWays; way++)
+			{
+				if (set[way].version.load(std::memory_order_relaxed) == 0)
+				{
+					victim = set + way;
+					break;
+				}
+				if (set[way].lastUsed.load(std::memory_order_relaxed) < victim->lastUsed.load(std::memory_order_relaxed))
+					victim = set + way;
+			}
+			const uint32_t version = victim->version.load(std::memory_order_relaxed);
+			victim->version.store(version + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (size_t i = 0; i < keyWords; i++)
+				victim->words[i].store(words[i], std::memory_order_relaxed);
+			for (size_t i = 0; i < 5; i++)
+				victim->words[keyWords + i].store(bits(coefficients[i]), std::memory_order_relaxed);
+			victim->version.store(version + 2, std::memory_order_release);
+			victim->lastUsed.store(clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+/*===================================================================================*/
+/*
+	[Function] Lookup only: true (and the coefficients) on a hit; never blocks
+*/
+		bool find(const CoefficientKey& key, double* coefficients)
+		{
+			uint64_t words[keyWords];
+			pack(key, words);
+			return find(entries + (hash(words) % numSets) * numWays, words, coefficients);
+		}
+/*===================================================================================*/
+/*
+	[Function] Statistics: designs the cache had to run, and entries in use
+*/
+		uint64_t getMisses() const
+		{
+			return misses.load(std::memory_order_relaxed);
+		}
+
+		size_t size() const
+		{
+			size_t count = 0;
+			for (const Entry& entry : entries)
+				count += entry.version.load(std::memory_order_relaxed) != 0 ? 1 : 0;
+			return count;
+		}
+	private:
+		static constexpr size_t keyWords = 5;
+
+		struct Entry
+		{
+			std::atomic<uint32_t> version{ 0 };				// 0 = empty, odd = being written
+			std::atomic<uint64_t> words[keyWords + 5] = {};	// key, then coefficients
+			std::atomic<uint64_t> lastUsed{ 0 };
+		};
+
+		CoefficientCache() = default;
+
+		bool find(Entry* set, const uint64_t* words, double* coefficients)
+		{
+			for (size_t way = 0; way < numWays; way++)
+			{
+				Entry& entry = set[way];
+				const uint32_t version = entry.version.load(std::memory_order_acquire);
+				if (version == 0 || (version & 1) != 0)
+					continue;
+				bool match = true;
+				for (size_t i = 0; i < keyWords && match; i++)
+					match = entry.words[i].load(std::memory_order_relaxed) == words[i];
+				if (!match)
+					continue;
+				double candidate[5];
+				for (size_t i = 0; i < 5; i++)
+				{
+					const uint64_t word = entry.words[keyWords + i].load(std::memory_order_relaxed);
+					std::memcpy(&candidate[i], &word, sizeof(double));
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (entry.version.load(std::memory_order_relaxed) != version)
+					continue;
+				std::memcpy(coefficients, candidate, sizeof(candidate));
+				// LRU at the resolution of the insert clock: a hit only writes if its stamp is stale
+				const uint64_t now = clock.load(std::memory_order_relaxed);
+				if (entry.lastUsed.load(std::memory_order_relaxed) != now)
+					entry.lastUsed.store(now, std::memory_order_relaxed);
+				return true;
+			}
+			return false;
+		}
+
+		static uint64_t bits(double value)
+		{
+			uint64_t word;
+			std::memcpy(&word, &value, sizeof(double));
+			return word;
+		}
+
+		static void pack(const CoefficientKey& key, uint64_t* words)
+		{
+			words[0] = static_cast<uint32_t>(key.algorithm);
+			words[1] = bits(key.fc);
+			words[2] = bits(key.Q);
+			words[3] = bits(key.boostCut);
+			words[4] = bits(key.sampleRate);
+		}
+
+		static uint64_t hash(const uint64_t* words)
+		{
+			// independent multiplies, so the hash isn't one long dependency chain
+			uint64_t h = words[0] * 0x9E3779B97F4A7C15ull + words[1] * 0xC2B2AE3D27D4EB4Full + words[2] * 0x165667B19E3779F9ull +
+				words[3] * 0xD6E8FEB86659FD93ull + words[4] * 0xFF51AFD7ED558CCDull;
+			return h ^ (h >> 29) ^ (h >> 47);
+		}
+
+		Entry entries[numSets * numWays];
+		std::atomic<uint64_t> clock{ 1 };
+		std::atomic<uint64_t> misses{ 0 };
+		std::mutex mutex;
+	};
+}
+#endif
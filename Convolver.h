@@ -0,0 +1,530 @@
+#pragma once
+#ifndef AuxPort_Convolver_H
+#define AuxPort_Convolver_H
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BackgroundWorker.h"
+#include "FFT.h"
+#include "Resampler.h"
+#include "WaveFile.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Zero latency partitioned convolution (a cabinet / impulse response stage)
+
+	The impulse response is split three ways:
+
+		head    the first headSize taps, a direct FIR run per sample
+		middle  taps up to 2 * tailSize in headSize partitions, uniformly partitioned
+		        overlap-save on the audio thread: one FFT, one multiply-accumulate over the
+		        frequency domain delay line and one inverse FFT every headSize samples
+		tail    the rest in tailSize partitions, the same scheme on the BackgroundWorker
+
+	Each FFT stage computes, at the end of an input block, a block that is only needed from
+	the next block (middle) or the one after (tail) on, so nothing adds latency and the
+	worker has a whole tailSize block of time for each job. Jobs and results travel through
+	small lock free rings. A result that isn't ready when its block starts (the worker fell
+	behind, or the host renders faster than real time) is computed on the audio thread
+	instead, after any job the worker is in the middle of, and counted by getLateBlocks().
+	So the output is always bit for bit the same as with setBackground(false), or with a
+	response short enough to have no tail, where everything runs inline.
+
+	load() / setImpulse() only store the response; prepare() (from reset(), allocates)
+	resamples it to the processing rate and builds the partitions.
+*/
+/*===================================================================================*/
+	template<class T>
+	class Convolver : public BackgroundTask
+	{
+	public:
+		static constexpr size_t headSize = 64;
+		static constexpr size_t tailSize = 2048;
+		static constexpr size_t maxLength = size_t(1) << 21;
+
+		Convolver() = default;
+		~Convolver()
+		{
+			stop();
+		}
+/*===================================================================================*/
+/*
+	[Function] Reads a WAV impulse response through a memory mapped file (channels are
+	averaged); false if it doesn't parse or is empty or longer than maxLength frames
+*/
+		bool load(const std::string& path)
+		{
+			WaveFile file;
+			if (!file.read(path) || file.frames() == 0)
+				return false;
+			std::vector<T> mono(file.frames(), T(0));
+			const T scale = T(1) / static_cast<T>(file.channels);
+			for (size_t i = 0; i < mono.size(); i++)
+			{
+				T sum = T(0);
+				for (size_t c = 0; c < file.channels; c++)
+					sum += static_cast<T>(file.samples[i * file.channels + c]);
+				mono[i] = sum * scale;
+			}
+			return setImpulse(mono.data(), mono.size(), file.sampleRate);
+		}
+
+		bool setImpulse(const T* samples, size_t length, double sampleRate)
+		{
+			if (length == 0 || length > maxLength || sampleRate <= 0.0)
+				return false;
+			impulse.assign(samples, samples + length);
+			impulseRate = sampleRate;
+			return true;
+		}
+
+		bool hasImpulse() const
+		{
+			return !impulse.empty();
+		}
+/*===================================================================================*/
+/*
+	[Function] Runs the tail on the worker (default) or inline; takes effect at prepare()
+*/
+		void setBackground(bool enabled)
+		{
+			background = enabled;
+		}
+/*===================================================================================*/
+/*
+	[Function] Resamples the response to sampleRate and builds the partitions (allocates;
+	not from the audio thread). Without a response, process() passes audio through.
+*/
+		void prepare(double sampleRate)
+		{
+			stop();
+			rate = sampleRate;
+			std::vector<T> response = resample(sampleRate);
+			length = std::min(response.size(), maxLength);
+			response.resize(length);
+
+			head.assign(headSize, T(0));
+			for (size_t k = 0; k < headSize && k < length; k++)
+				head[headSize - 1 - k] = response[k];
+			history.assign(2 * headSize, T(0));
+
+			middle.prepare(response, headSize, std::min(length, 2 * tailSize), headSize);
+			tail.prepare(response, 2 * tailSize, length, tailSize);
+			for (Job& job : jobs)
+				job.frame.assign(2 * tailSize, T(0));
+			for (Result& result : results)
+				result.samples.assign(tailSize, T(0));
+			tailInput.assign(2 * tailSize, T(0));
+			silence.assign(tailSize, T(0));
+			clear();
+			if (background && tail.partitions > 0)
+				start();
+		}
+/*===================================================================================*/
+/*
+	[Function] Clears the signal state (not while process() or the worker can run; prepare()
+	calls it)
+*/
+		void clear()
+		{
+			std::fill(history.begin(), history.end(), T(0));
+			position = 0;
+			middle.clear();
+			tail.clear();
+			std::fill(tailInput.begin(), tailInput.end(), T(0));
+			headFill = 0;
+			tailFill = 0;
+			tailBlock = 0;
+			tailOutput = silence.data();
+			jobsPosted.store(0, std::memory_order_relaxed);
+			jobsDone.store(0, std::memory_order_relaxed);
+			for (Result& result : results)
+				result.state.store(Result::free, std::memory_order_relaxed);
+			reading = nullptr;
+			tailBusy.store(false, std::memory_order_relaxed);
+		}
+/*===================================================================================*/
+/*
+	[Function] Convolves numSamples samples in place (audio thread)
+*/
+		void process(T* buffer, size_t numSamples)
+		{
+			if (length == 0)
+				return;
+			for (size_t start = 0; start < numSamples; )
+			{
+				const size_t count = std::min(numSamples - start, headSize - headFill);
+				T* block = buffer + start;
+				if (tail.partitions > 0)
+					std::memcpy(tailInput.data() + tailSize + tailFill, block, count * sizeof(T));
+				std::memcpy(middle.input.data() + headSize + headFill, block, count * sizeof(T));
+				for (size_t i = 0; i < count; i++)
+				{
+					history[position] = block[i];
+					history[position + headSize] = block[i];
+					position = position + 1 == headSize ? 0 : position + 1;
+					const T* window = history.data() + position;
+					T sum = T(0);
+					for (size_t k = 0; k < headSize; k++)
+						sum += head[k] * window[k];
+					block[i] = sum;
+				}
+				const T* middleOutput = middle.output.data() + headFill;
+				const T* tailBlockOutput = tailOutput + tailFill;
+				for (size_t i = 0; i < count; i++)
+					block[i] += middleOutput[i] + tailBlockOutput[i];
+				headFill += count;
+				tailFill += count;
+				start += count;
+				if (headFill == headSize)
+				{
+					middle.run();
+					headFill = 0;
+				}
+				if (tailFill == tailSize)
+				{
+					finishTailBlock();
+					tailFill = 0;
+				}
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Statistics: tail blocks the worker didn't deliver in time, which the audio
+	thread then computed itself, and the response length at the processing rate
+*/
+		uint64_t getLateBlocks() const
+		{
+			return lateBlocks.load(std::memory_order_relaxed);
+		}
+
+		size_t getLength() const
+		{
+			return length;
+		}
+/*===================================================================================*/
+/*
+	[Function] Worker thread: runs every posted tail job in order, one at a time so the
+	audio thread can take over between jobs
+*/
+		void service() override
+		{
+			while (jobsDone.load(std::memory_order_acquire) != jobsPosted.load(std::memory_order_acquire))
+			{
+				// the audio thread is catching up; it requests service again for what it leaves
+				if (tailBusy.exchange(true, std::memory_order_acquire))
+					return;
+				runNextJob();
+				tailBusy.store(false, std::memory_order_release);
+			}
+		}
+	private:
+		static constexpr size_t numSlots = 4;
+/*===================================================================================*/
+/*
+	[Struct] One uniformly partitioned overlap-save section: partitions of size taps from
+	first to last, each spectrum a 2 * size FFT, and the delay line of input spectra
+*/
+		struct Section
+		{
+			size_t size = 0;
+			size_t bins = 0;
+			size_t partitions = 0;
+			size_t newest = 0;
+			std::vector<T> filterRe, filterIm;
+			std::vector<T> lineRe, lineIm;
+			std::vector<T> sumRe, sumIm;
+			std::vector<T> input;		// previous block, current block
+			std::vector<T> output;		// the block for the next one (middle) / scratch (tail)
+			RealFFT<T> transform;
+
+			void prepare(const std::vector<T>& response, size_t first, size_t last, size_t blockSize)
+			{
+				size = blockSize;
+				bins = size + 1;
+				partitions = last > first ? (last - first + size - 1) / size : 0;
+				transform.prepare(2 * size);
+				filterRe.assign(partitions * bins, T(0));
+				filterIm.assign(partitions * bins, T(0));
+				std::vector<T> frame(2 * size, T(0));
+				for (size_t p = 0; p < partitions; p++)
+				{
+					std::fill(frame.begin(), frame.end(), T(0));
+					for (size_t k = 0; k < size && first + p * size + k < last; k++)
+						frame[k] = response[first + p * size + k];
+					transform.forward(frame.data(), filterRe.data() + p * bins, filterIm.data() + p * bins);
+				}
+				lineRe.assign(partitions * bins, T(0));
+				lineIm.assign(partitions * bins, T(0));
+				sumRe.assign(bins, T(0));
+				sumIm.assign(bins, T(0));
+				input.assign(2 * size, T(0));
+				output.assign(2 * size, T(0));
+			}
+
+			void clear()
+			{
+				std::fill(lineRe.begin(), lineRe.end(), T(0));
+				std::fill(lineIm.begin(), lineIm.end(), T(0));
+				std::fill(input.begin(), input.end(), T(0));
+				std::fill(output.begin(), output.end(), T(0));
+				newest = 0;
+			}
+/*===================================================================================*/
+/*
+	[Function] Takes in a 2 * size frame (previous block, current block) and leaves the sum
+	over the partitions for the matching output block in output[size, 2 * size)
+*/
+			void convolve(const T* block)
+			{
+				newest = newest == 0 ? partitions - 1 : newest - 1;
+				transform.forward(block, lineRe.data() + newest * bins, lineIm.data() + newest * bins);
+				std::fill(sumRe.begin(), sumRe.end(), T(0));
+				std::fill(sumIm.begin(), sumIm.end(), T(0));
+				for (size_t p = 0; p < partitions; p++)
+				{
+					const size_t slot = (newest + p) % partitions;
+					multiplyAdd(filterRe.data() + p * bins, filterIm.data() + p * bins, lineRe.data() + slot * bins, lineIm.data() + slot * bins,
+						sumRe.data(), sumIm.data(), bins);
+				}
+				transform.inverse(sumRe.data(), sumIm.data(), output.data());
+			}
+/*===================================================================================*/
+/*
+	[Function] Middle section: at the end of a headSize block, the block after it
+*/
+			void run()
+			{
+				if (partitions == 0)
+					return;
+				convolve(input.data());
+				std::memmove(output.data(), output.data() + size, size * sizeof(T));
+				std::memcpy(input.data(), input.data() + size, size * sizeof(T));
+			}
+		};
+
+		struct Job
+		{
+			std::vector<T> frame;
+			uint64_t block = 0;
+		};
+
+		struct Result
+		{
+			enum : int { free, writing, ready, reading };
+			std::atomic<int> state{ free };
+			uint64_t block = 0;
+			std::vector<T> samples;
+		};
+/*===================================================================================*/
+/*
+	[Function] Split complex multiply-accumulate, sum += a * b, written so it vectorizes
+*/
+		static void multiplyAdd(const T* aRe, const T* aIm, const T* bRe, const T* bIm, T* sumRe, T* sumIm, size_t count)
+		{
+			for (size_t k = 0; k < count; k++)
+			{
+				sumRe[k] += aRe[k] * bRe[k] - aIm[k] * bIm[k];
+				sumIm[k] += aRe[k] * bIm[k] + aIm[k] * bRe[k];
+			}
+		}
+
+		void start()
+		{
+			if (attached)
+				return;
+			BackgroundWorker::get().attach(this);
+			attached = true;
+		}
+
+		void stop()
+		{
+			if (!attached)
+				return;
+			BackgroundWorker::get().detach(this);
+			attached = false;
+		}
+
+		std::vector<T> resample(double sampleRate) const
+		{
+			if (impulse.empty() || std::llround(impulseRate) == std::llround(sampleRate))
+				return impulse;
+			Resampler<T> resampler;
+			if (!resampler.prepare(impulseRate, sampleRate))
+				return impulse;
+			std::vector<T> input(impulse);
+			input.resize(impulse.size() + 64, T(0));
+			std::vector<T> output(resampler.maxOutput(input.size()), T(0));
+			output.resize(resampler.process(input.data(), input.size(), output.data()));
+			// the resampler's delay (well under a millisecond) stays in the response: cutting it
+			// off would cut off the pre-ringing too and change the response's gain
+			const T scale = static_cast<T>(impulseRate / sampleRate);
+			for (T& sample : output)
+				sample *= scale;
+			return output;
+		}
+/*===================================================================================*/
+/*
+	[Function] End of a tailSize block on the audio thread: hands the block to the tail and
+	picks up the tail's output for the next one
+*/
+		void finishTailBlock()
+		{
+			if (tail.partitions == 0)
+				return;
+			const uint64_t block = tailBlock++;
+			if (background)
+			{
+				const uint64_t posted = jobsPosted.load(std::memory_order_relaxed);
+				// the worker is numSlots blocks behind: free a slot by running its oldest job here
+				if (posted - jobsDone.load(std::memory_order_acquire) == numSlots)
+					catchUp([this, posted]() { return posted - jobsDone.load(std::memory_order_relaxed) < numSlots; });
+				Job& job = jobs[posted % numSlots];
+				std::memcpy(job.frame.data(), tailInput.data(), 2 * tailSize * sizeof(T));
+				job.block = block;
+				jobsPosted.store(posted + 1, std::memory_order_release);
+				requestService();
+			}
+			else
+			{
+				Job job;
+				job.frame.swap(tailInput);
+				job.block = block;
+				runJob(job);
+				job.frame.swap(tailInput);
+			}
+			std::memcpy(tailInput.data(), tailInput.data() + tailSize, tailSize * sizeof(T));
+			pickUpTail(block + 1);
+		}
+
+		void pickUpTail(uint64_t block)
+		{
+			if (reading)
+			{
+				reading->state.store(Result::free, std::memory_order_release);
+				reading = nullptr;
+			}
+			tailOutput = silence.data();
+			// the first two blocks are before the tail starts
+			if (block < 2)
+				return;
+			if (!takeResult(block))
+			{
+				catchUp([this, block]() { return ready(block); });
+				takeResult(block);
+			}
+		}
+
+		bool ready(uint64_t block) const
+		{
+			for (const Result& result : results)
+			{
+				if (result.state.load(std::memory_order_acquire) == Result::ready && result.block == block)
+					return true;
+			}
+			return false;
+		}
+/*===================================================================================*/
+/*
+	[Function] Reads block's result from the next block on if it is ready, and frees any
+	older one left over
+*/
+		bool takeResult(uint64_t block)
+		{
+			for (Result& result : results)
+			{
+				if (result.state.load(std::memory_order_acquire) != Result::ready)
+					continue;
+				if (result.block == block)
+				{
+					result.state.store(Result::reading, std::memory_order_relaxed);
+					reading = &result;
+					tailOutput = result.samples.data();
+				}
+				else if (result.block < block)
+					result.state.store(Result::free, std::memory_order_release);
+			}
+			return reading != nullptr;
+		}
+/*===================================================================================*/
+/*
+	[Function] Audio thread, when the worker is late: waits out the job the worker is in the
+	middle of (if any) and runs posted jobs here until done() holds
+*/
+		template<class Done>
+		void catchUp(Done done)
+		{
+			lateBlocks.fetch_add(1, std::memory_order_relaxed);
+			while (tailBusy.exchange(true, std::memory_order_acquire))
+				std::this_thread::yield();
+			while (!done() && runNextJob())
+				;
+			tailBusy.store(false, std::memory_order_release);
+			if (jobsDone.load(std::memory_order_relaxed) != jobsPosted.load(std::memory_order_relaxed))
+				requestService();
+		}
+/*===================================================================================*/
+/*
+	[Function] Runs the oldest posted job, false if there is none (the caller holds tailBusy)
+*/
+		bool runNextJob()
+		{
+			const uint64_t index = jobsDone.load(std::memory_order_relaxed);
+			if (index == jobsPosted.load(std::memory_order_acquire))
+				return false;
+			runJob(jobs[index % numSlots]);
+			jobsDone.store(index + 1, std::memory_order_release);
+			return true;
+		}
+/*===================================================================================*/
+/*
+	[Function] Tail job for block: its output is the block two on
+*/
+		void runJob(const Job& job)
+		{
+			tail.convolve(job.frame.data());
+			Result& result = results[(job.block + 2) % numSlots];
+			int expected = Result::free;
+			if (!result.state.compare_exchange_strong(expected, Result::writing, std::memory_order_acquire))
+				return;
+			std::memcpy(result.samples.data(), tail.output.data() + tailSize, tailSize * sizeof(T));
+			result.block = job.block + 2;
+			result.state.store(Result::ready, std::memory_order_release);
+		}
+
+		std::vector<T> impulse;
+		double impulseRate = 0.0;
+		double rate = 0.0;
+		size_t length = 0;
+		bool background = true;
+		bool attached = false;
+
+		std::vector<T> head;			// reversed
+		std::vector<T> history;			// kept twice, as in Resampler
+		size_t position = 0;
+		Section middle;
+		Section tail;
+		size_t headFill = 0;
+		size_t tailFill = 0;
+		uint64_t tailBlock = 0;
+		std::vector<T> tailInput;
+		std::vector<T> silence;
+		const T* tailOutput = nullptr;
+
+		Job jobs[numSlots];
+		Result results[numSlots];
+		Result* reading = nullptr;
+		std::atomic<bool> tailBusy{ false };	// whoever runs a tail job holds it
+		std::atomic<uint64_t> jobsPosted{ 0 };
+		std::atomic<uint64_t> jobsDone{ 0 };
+		std::atomic<uint64_t> lateBlocks{ 0 };
+	};
+}
+#endif
@@ -0,0 +1,508 @@
+#pragma once
+#ifndef AuxPort_Dispatch_H
+#define AuxPort_Dispatch_H
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "FastMath.h"
+#include "Kernels.h"
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define AUXPORT_X86 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define AUXPORT_X86 1
+#endif
+/*
+	Per-function instruction set targets. gcc and clang compile each variant for its ISA;
+	MSVC has no per-function targets, so there every variant is the same baseline build
+	and dispatch only matters if the plugin itself is built with /arch.
+*/
+#if defined(AUXPORT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AUXPORT_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define AUXPORT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define AUXPORT_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx2,fma")))
+#else
+#define AUXPORT_TARGET_SSE42
+#define AUXPORT_TARGET_AVX2
+#define AUXPORT_TARGET_AVX512
+#endif
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Enum] Instruction set levels a kernel can be compiled for (ordered)
+*/
+/*===================================================================================*/
+	enum class ISA
+	{
+		Generic, SSE42, AVX2, AVX512
+	};
+
+	inline const char* toString(ISA isa)
+	{
+		switch (isa)
+		{
+		case ISA::SSE42: return "sse4.2";
+		case ISA::AVX2: return "avx2";
+		case ISA::AVX512: return "avx512";
+		default: return "generic";
+		}
+	}
+
+	inline ISA toISA(const std::string& name)
+	{
+		if (name == "sse4.2") return ISA::SSE42;
+		if (name == "avx2") return ISA::AVX2;
+		if (name == "avx512") return ISA::AVX512;
+		return ISA::Generic;
+	}
+
+/*===================================================================================*/
+/*
+	[Struct] What this CPU (and OS) can run, read once from CPUID
+*/
+/*===================================================================================*/
+	struct CpuInfo
+	{
+		ISA isa = ISA::Generic;
+		std::string model = "generic";
+
+		static const CpuInfo& get()
+		{
+			static const CpuInfo info = detect();
+			return info;
+		}
+	private:
+		static CpuInfo detect()
+		{
+			CpuInfo info;
+#if defined(AUXPORT_X86)
+			uint32_t r[4];
+			cpuid(0, r);
+			uint32_t maxLeaf = r[0];
+			cpuid(1, r);
+			bool sse42 = (r[2] >> 20) & 1;
+			bool fma = (r[2] >> 12) & 1;
+			bool osxsave = (r[2] >> 27) & 1;
+			bool avx = (r[2] >> 28) & 1;
+			uint64_t xcr0 = osxsave ? xgetbv() : 0;
+			bool osAvx = (xcr0 & 0x6) == 0x6;
+			bool osAvx512 = (xcr0 & 0xe6) == 0xe6;
+			bool avx2 = false, avx512 = false;
+			if (maxLeaf >= 7)
+			{
+				cpuid(7, r);
+				avx2 = (r[1] >> 5) & 1;
+				avx512 = ((r[1] >> 16) & 1) && ((r[1] >> 31) & 1);
+			}
+			if (sse42)
+				info.isa = ISA::SSE42;
+			if (sse42 && avx && avx2 && fma && osAvx)
+				info.isa = ISA::AVX2;
+			if (info.isa == ISA::AVX2 && avx512 && osAvx512)
+				info.isa = ISA::AVX512;
+
+			cpuid(0x80000000u, r);
+			if (r[0] >= 0x80000004u)
+			{
+				char brand[49] = {};
+				for (uint32_t leaf = 0; leaf < 3; leaf++)
+				{
+					cpuid(0x80000002u + leaf, r);
+					std::memcpy(brand + 16 * leaf, r, 16);
+				}
+				std::string model(brand);
+				model.erase(0, model.find_first_not_of(' '));
+				model.erase(model.find_last_not_of(' ') + 1);
+				if (!model.empty())
+					info.model = model;
+			}
+#endif
+			return info;
+		}
+#if defined(AUXPORT_X86)
+		static void cpuid(uint32_t leaf, uint32_t* r)
+		{
+#if defined(_MSC_VER)
+			int registers[4];
+			__cpuidex(registers, static_cast<int>(leaf), 0);
+			std::memcpy(r, registers, sizeof(registers));
+#else
+			__cpuid_count(leaf, 0, r[0], r[1], r[2], r[3]);
+#endif
+		}
+		static uint64_t xgetbv()
+		{
+#if defined(_MSC_VER)
+			return _xgetbv(0);
+#else
+			uint32_t eax, edx;
+			__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+		}
+#endif
+	};
+
+/*===================================================================================*/
+/*
+	[Struct] One compiled copy of every block kernel per ISA
+*/
+/*===================================================================================*/
+#define AUXPORT_KERNEL_VARIANT(Name, Target) \
+	template<class T> \
+	struct Name \
+	{ \
+		Target static void biquad(const T* input, T* output, size_t numSamples, const T* coefficients, T& z1, T& z2) \
+		{ Kernel::biquad<T>(input, output, numSamples, coefficients, z1, z2); } \
+		Target static void crossover(const T* left, const T* right, T* lowLeft, T* lowRight, T* highLeft, T* highRight, size_t numSamples, const T* coefficients, T* state, int order, T gain) \
+		{ Kernel::crossover<T>(left, right, lowLeft, lowRight, highLeft, highRight, numSamples, coefficients, state, order, gain); } \
+		Target static void fullWave(T* buffer, size_t numSamples, T& previousFrame, T& previousProcessedFrame) \
+		{ Kernel::fullWave<T>(buffer, numSamples, previousFrame, previousProcessedFrame); } \
+		template<Accuracy accuracy> Target static void arcTan(T* buffer, size_t numSamples, T scale, T gain) \
+		{ FastMath<T>::template atanBlock<accuracy>(buffer, numSamples, scale, gain); } \
+		template<Accuracy accuracy> Target static void arcTanH(T* buffer, size_t numSamples, T scale, T gain) \
+		{ FastMath<T>::template atanhBlock<accuracy>(buffer, numSamples, scale, gain); } \
+	};
+
+	AUXPORT_KERNEL_VARIANT(GenericKernels, )
+	AUXPORT_KERNEL_VARIANT(SSE42Kernels, AUXPORT_TARGET_SSE42)
+	AUXPORT_KERNEL_VARIANT(AVX2Kernels, AUXPORT_TARGET_AVX2)
+	AUXPORT_KERNEL_VARIANT(AVX512Kernels, AUXPORT_TARGET_AVX512)
+#undef AUXPORT_KERNEL_VARIANT
+
+/*===================================================================================*/
+/*
+	[Class] Runtime kernel table. Starts out on the best ISA CPUID reports; the AutoTuner may
+	then move individual kernels to whichever ISA actually measured fastest. The entries
+	are atomics so retuning from one instance never tears a pointer another instance's
+	audio thread is reading.
+*/
+/*===================================================================================*/
+	template<class T>
+	class Dispatch
+	{
+	public:
+		using Biquad = void(*)(const T*, T*, size_t, const T*, T&, T&);
+		using CrossoverKernel = void(*)(const T*, const T*, T*, T*, T*, T*, size_t, const T*, T*, int, T);
+		using FullWaveKernel = void(*)(T*, size_t, T&, T&);
+		using Shaper = void(*)(T*, size_t, T, T);
+
+		static void biquad(const T* input, T* output, size_t numSamples, const T* coefficients, T& z1, T& z2)
+		{
+			table().biquad.load(std::memory_order_relaxed)(input, output, numSamples, coefficients, z1, z2);
+		}
+		static void crossover(const T* left, const T* right, T* lowLeft, T* lowRight, T* highLeft, T* highRight, size_t numSamples, const T* coefficients, T* state, int order, T gain)
+		{
+			table().crossover.load(std::memory_order_relaxed)(left, right, lowLeft, lowRight, highLeft, highRight, numSamples, coefficients, state, order, gain);
+		}
+		static void fullWave(T* buffer, size_t numSamples, T& previousFrame, T& previousProcessedFrame)
+		{
+			table().fullWave.load(std::memory_order_relaxed)(buffer, numSamples, previousFrame, previousProcessedFrame);
+		}
+		static void arcTan(T* buffer, size_t numSamples, T scale, T gain, Accuracy accuracy)
+		{
+			table().arcTan[static_cast<int>(accuracy)].load(std::memory_order_relaxed)(buffer, numSamples, scale, gain);
+		}
+		static void arcTanH(T* buffer, size_t numSamples, T scale, T gain, Accuracy accuracy)
+		{
+			table().arcTanH[static_cast<int>(accuracy)].load(std::memory_order_relaxed)(buffer, numSamples, scale, gain);
+		}
+/*===================================================================================*/
+/*
+	[Function] Moves one kernel family to another ISA (clamped to what the CPU supports)
+*/
+		static void useBiquad(ISA isa)
+		{
+			installBiquad(table(), isa);
+		}
+		static void useFullWave(ISA isa)
+		{
+			installFullWave(table(), isa);
+		}
+		static void useShapers(ISA isa)
+		{
+			installShapers(table(), isa);
+		}
+	private:
+		struct Table
+		{
+			std::atomic<Biquad> biquad;
+			std::atomic<CrossoverKernel> crossover;
+			std::atomic<FullWaveKernel> fullWave;
+			std::atomic<Shaper> arcTan[3];
+			std::atomic<Shaper> arcTanH[3];
+		};
+
+		static Table& table()
+		{
+			static Table instance;
+			static const bool ready = initialize(instance);
+			(void)ready;
+			return instance;
+		}
+
+		static bool initialize(Table& target)
+		{
+			ISA best = CpuInfo::get().isa;
+			installBiquad(target, best);
+			installFullWave(target, best);
+			installShapers(target, best);
+			return true;
+		}
+
+		static void installBiquad(Table& target, ISA isa)
+		{
+			target.biquad = select(isa, &GenericKernels<T>::biquad, &SSE42Kernels<T>::biquad, &AVX2Kernels<T>::biquad, &AVX512Kernels<T>::biquad);
+			// the crossover is the same kind of recurrence, so it follows the biquad's tuning
+			target.crossover = select(isa, &GenericKernels<T>::crossover, &SSE42Kernels<T>::crossover, &AVX2Kernels<T>::crossover, &AVX512Kernels<T>::crossover);
+		}
+
+		static void installFullWave(Table& target, ISA isa)
+		{
+			target.fullWave = select(isa, &GenericKernels<T>::fullWave, &SSE42Kernels<T>::fullWave, &AVX2Kernels<T>::fullWave, &AVX512Kernels<T>::fullWave);
+		}
+
+		template<Accuracy accuracy>
+		static void installShaper(Table& target, ISA isa)
+		{
+			const int i = static_cast<int>(accuracy);
+			target.arcTan[i] = select(isa, &GenericKernels<T>::template arcTan<accuracy>, &SSE42Kernels<T>::template arcTan<accuracy>, &AVX2Kernels<T>::template arcTan<accuracy>, &AVX512Kernels<T>::template arcTan<accuracy>);
+			target.arcTanH[i] = select(isa, &GenericKernels<T>::template arcTanH<accuracy>, &SSE42Kernels<T>::template arcTanH<accuracy>, &AVX2Kernels<T>::template arcTanH<accuracy>, &AVX512Kernels<T>::template arcTanH<accuracy>);
+		}
+
+		static void installShapers(Table& target, ISA isa)
+		{
+			installShaper<Accuracy::Low>(target, isa);
+			installShaper<Accuracy::Medium>(target, isa);
+			installShaper<Accuracy::High>(target, isa);
+		}
+
+		template<class Function>
+		static Function select(ISA isa, Function generic, Function sse42, Function avx2, Function avx512)
+		{
+			ISA supported = CpuInfo::get().isa;
+			isa = static_cast<int>(isa) > static_cast<int>(supported) ? supported : isa;
+			switch (isa)
+			{
+			case ISA::AVX512: return avx512;
+			case ISA::AVX2: return avx2;
+			case ISA::SSE42: return sse42;
+			default: return generic;
+			}
+		}
+	};
+
+/*===================================================================================*/
+/*
+	[Struct] Outcome of a tuning run
+*/
+/*===================================================================================*/
+	struct TuneResult
+	{
+		ISA biquad = ISA::Generic;
+		ISA fullWave = ISA::Generic;
+		ISA shapers = ISA::Generic;
+		size_t subBlockSize = 64;
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Startup micro auto-tuner
+
+	- times every kernel family on every ISA this CPU supports and keeps the fastest
+	- times a caller-supplied workload at each candidate sub-block size
+	- results are cached in a text file named after the CPU model, so only the first start
+	  on a given machine pays for the measurement (a few tens of milliseconds)
+*/
+/*===================================================================================*/
+	class AutoTuner
+	{
+	public:
+		static constexpr size_t subBlockCandidates[] = { 16, 32, 64, 128, 256 };
+/*===================================================================================*/
+/*
+	[Function] Runs the measurements. workload(left, right, numSamples, subBlockSize) should
+	process the buffers the way the plugin would with that sub-block size.
+*/
+		template<class Workload>
+		static TuneResult tune(Workload&& workload)
+		{
+			TuneResult result;
+			std::vector<float> buffer(probeSize), scratch(probeSize);
+			fillProbe(buffer);
+			const float coefficients[5] = { 0.2f, 0.4f, 0.2f, -0.6f, 0.3f };
+			const int levels = static_cast<int>(CpuInfo::get().isa);
+
+			double best[3] = { 1e30, 1e30, 1e30 };
+			for (int level = 0; level <= levels; level++)
+			{
+				ISA isa = static_cast<ISA>(level);
+				Dispatch<float>::useBiquad(isa);
+				Dispatch<float>::useFullWave(isa);
+				Dispatch<float>::useShapers(isa);
+				double biquadTime = measure([&]()
+				{
+					float z1 = 0, z2 = 0;
+					Dispatch<float>::biquad(buffer.data(), scratch.data(), probeSize, coefficients, z1, z2);
+				});
+				double fullWaveTime = measure([&]()
+				{
+					float previous = 0, accumulated = 0;
+					std::copy(buffer.begin(), buffer.end(), scratch.begin());
+					Dispatch<float>::fullWave(scratch.data(), probeSize, previous, accumulated);
+				});
+				double shaperTime = measure([&]()
+				{
+					std::copy(buffer.begin(), buffer.end(), scratch.begin());
+					Dispatch<float>::arcTan(scratch.data(), probeSize, 2.0f, 0.5f, Accuracy::High);
+				});
+				if (biquadTime < best[0]) { best[0] = biquadTime; result.biquad = isa; }
+				if (fullWaveTime < best[1]) { best[1] = fullWaveTime; result.fullWave = isa; }
+				if (shaperTime < best[2]) { best[2] = shaperTime; result.shapers = isa; }
+			}
+			apply(result);
+
+			std::vector<float> left(probeSize), right(probeSize);
+			double bestBlock = 1e30;
+			for (size_t candidate : subBlockCandidates)
+			{
+				double time = measure([&]()
+				{
+					std::copy(buffer.begin(), buffer.end(), left.begin());
+					std::copy(buffer.rbegin(), buffer.rend(), right.begin());
+					workload(left.data(), right.data(), probeSize, candidate);
+				});
+				if (time < bestBlock)
+				{
+					bestBlock = time;
+					result.subBlockSize = candidate;
+				}
+			}
+			return result;
+		}
+/*===================================================================================*/
+/*
+	[Function] Installs a result in the float kernel table
+*/
+		static void apply(const TuneResult& result)
+		{
+			Dispatch<float>::useBiquad(result.biquad);
+			Dispatch<float>::useFullWave(result.fullWave);
+			Dispatch<float>::useShapers(result.shapers);
+		}
+/*===================================================================================*/
+/*
+	[Function] Cache file for this CPU inside directory
+*/
+		static std::string cachePath(const std::string& directory)
+		{
+			std::string name = CpuInfo::get().model;
+			for (char& c : name)
+			{
+				if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+					c = '_';
+			}
+			return (std::filesystem::path(directory) / ("AuxPortTune_" + name + ".txt")).string();
+		}
+
+/*===================================================================================*/
+/*
+	[Function] Reads a cache written by save(); false (a miss, so tune again) if it is for
+	another CPU or version, incomplete or corrupt. Never throws.
+*/
+		static bool load(const std::string& path, TuneResult& result)
+		{
+			std::ifstream file(path);
+			std::string key, value;
+			bool matched = false;
+			size_t fields = 0;
+			while (file >> key && std::getline(file >> std::ws, value))
+			{
+				if (key == "version" && value != std::to_string(cacheVersion))
+					return false;
+				else if (key == "cpu")
+					matched = value == CpuInfo::get().model;
+				else if (key == "biquad") { result.biquad = toISA(value); fields++; }
+				else if (key == "fullWave") { result.fullWave = toISA(value); fields++; }
+				else if (key == "shapers") { result.shapers = toISA(value); fields++; }
+				else if (key == "subBlockSize")
+				{
+					if (!parseSubBlockSize(value, result.subBlockSize))
+						return false;
+					fields++;
+				}
+			}
+			return matched && fields == 4;
+		}
+
+		static bool save(const std::string& path, const TuneResult& result)
+		{
+			std::ofstream file(path, std::ios::trunc);
+			file << "version " << cacheVersion << "\n"
+				<< "cpu " << CpuInfo::get().model << "\n"
+				<< "biquad " << toString(result.biquad) << "\n"
+				<< "fullWave " << toString(result.fullWave) << "\n"
+				<< "shapers " << toString(result.shapers) << "\n"
+				<< "subBlockSize " << result.subBlockSize << "\n";
+			return static_cast<bool>(file);
+		}
+	private:
+		static constexpr int cacheVersion = 1;
+		static constexpr size_t probeSize = 4096;
+
+		static bool parseSubBlockSize(const std::string& value, size_t& size)
+		{
+			char* end = nullptr;
+			errno = 0;
+			const unsigned long parsed = std::strtoul(value.c_str(), &end, 10);
+			if (value.empty() || end != value.c_str() + value.size() || errno == ERANGE)
+				return false;
+			for (size_t candidate : subBlockCandidates)
+			{
+				if (parsed == candidate)
+				{
+					size = candidate;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		static void fillProbe(std::vector<float>& buffer)
+		{
+			uint32_t seed = 0x12345678u;
+			for (size_t i = 0; i < buffer.size(); i++)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				buffer[i] = static_cast<float>(seed >> 8) * (2.0f / 16777216.0f) - 1.0f;
+			}
+		}
+
+		template<class Body>
+		static double measure(Body&& body)
+		{
+			body();
+			double best = 1e30;
+			for (int trial = 0; trial < 7; trial++)
+			{
+				auto start = std::chrono::steady_clock::now();
+				for (int repeat = 0; repeat < 4; repeat++)
+					body();
+				best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+			}
+			return best;
+		}
+	};
+}
+#endif
@@ -0,0 +1,145 @@
+#ifndef AuxPort_EffectPool_H
+#define AuxPort_EffectPool_H
+#pragma once
+/*
+*			AuxPort Effect Pool
+			Pre-constructed, pre-prepared Effect instances for servers that start streams on demand.
+			See LICENSE in the repository root.
+*/
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "plugincore.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Effect pool
+
+	prepare() pays for everything a new stream would otherwise pay on its audio path:
+	construction, reset(), prepareToPlay() and a run of silence that cooks the gains and
+	settles the filters. Each instance owns its control values (bound, defaults from
+	parameterTable). acquire() hands out a ready instance, optionally cloned from a
+	snapshot of a running one in O(state size); release() rewinds it to the freshly
+	prepared snapshot and puts it back. acquire() and release() don't allocate and only
+	hold the lock for a push or pop, so any thread may call them.
+*/
+/*===================================================================================*/
+	template<class bufferType, class effectType>
+	class EffectPool
+	{
+	public:
+		struct Instance
+		{
+			Effect<bufferType, effectType> effect;
+			float controls[parameterTable.size()];
+		};
+
+		EffectPool() = default;
+		EffectPool(const EffectPool&) = delete;
+		EffectPool& operator=(const EffectPool&) = delete;
+		~EffectPool() = default;
+/*===================================================================================*/
+/*
+	[Function] Builds count instances for sampleRate (allocates; false while any instance is
+	still acquired, or if count is 0). lookaheadMs is the output limiter's, see
+	Effect::setLookahead; snapshots only fit instances with the same one.
+*/
+		bool prepare(size_t count, double sampleRate, double internalRate = 0.0, size_t subBlockSize = 64, size_t settleSamples = 1024, double lookaheadMs = 0.0)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (count == 0 || free.size() != instances.size())
+				return false;
+			free.clear();
+			instances.clear();
+			instances.reserve(count);
+			free.reserve(count);
+			std::vector<bufferType> silence(Effect<bufferType, effectType>::maxSubBlockSize, bufferType(0));
+			for (size_t i = 0; i < count; i++)
+			{
+				std::unique_ptr<Instance> instance(new Instance());
+				parameterTable.setDefaults(instance->controls);
+				Effect<bufferType, effectType>& effect = instance->effect;
+				effect.bind({ instance->controls, parameterTable.slotMap() });
+				effect.setInternalRate(internalRate);
+				effect.setLookahead(lookaheadMs);
+				effect.setSubBlockSize(subBlockSize);
+				effect.reset(static_cast<bufferType>(sampleRate));
+				effect.prepareToPlay(static_cast<bufferType>(sampleRate));
+				for (size_t done = 0; done < settleSamples; done += silence.size())
+				{
+					const size_t n = settleSamples - done < silence.size() ? settleSamples - done : silence.size();
+					effect.run(silence.data(), silence.data(), n);
+				}
+				free.push_back(instance.get());
+				instances.push_back(std::move(instance));
+			}
+			instances.front()->effect.snapshot(pristine);
+			return true;
+		}
+/*===================================================================================*/
+/*
+	[Function] A ready instance, or nullptr if the pool is empty. With a snapshot, the
+	instance is a clone of the Effect that took it (nullptr if the snapshot doesn't fit,
+	see Effect::restore; the instance stays in the pool).
+*/
+		Instance* acquire(const uint8_t* snapshot = nullptr, size_t size = 0)
+		{
+			Instance* instance = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (free.empty())
+					return nullptr;
+				instance = free.back();
+				free.pop_back();
+			}
+			if (snapshot && !instance->effect.restore(snapshot, size))
+			{
+				rewind(instance);
+				return nullptr;
+			}
+			return instance;
+		}
+
+		Instance* acquire(const std::vector<uint8_t>& snapshot)
+		{
+			return acquire(snapshot.data(), snapshot.size());
+		}
+/*===================================================================================*/
+/*
+	[Function] Hands an instance back; it is ready for the next acquire() straight away
+*/
+		void release(Instance* instance)
+		{
+			if (instance)
+				rewind(instance);
+		}
+
+		size_t available() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return free.size();
+		}
+
+		size_t capacity() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return instances.size();
+		}
+	private:
+		void rewind(Instance* instance)
+		{
+			instance->effect.restore(pristine.data(), pristine.size());
+			std::lock_guard<std::mutex> lock(mutex);
+			free.push_back(instance);
+		}
+
+		mutable std::mutex mutex;
+		std::vector<std::unique_ptr<Instance>> instances;
+		std::vector<Instance*> free;
+		std::vector<uint8_t> pristine;
+	};
+}
+#endif
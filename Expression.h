@@ -0,0 +1,251 @@
+#pragma once
+#ifndef AuxPort_Expression_H
+#define AuxPort_Expression_H
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include "FastMath.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Namespace] Expression templates over the elementwise block stages
+
+	An expression such as
+
+		evaluate(output, numSamples, wL * signal(highPassLeft) + wC * stereoToMono(signal(left), signal(right)))
+
+	builds a small tree of types at compile time and runs as one loop that reads each input
+	once and writes output once: no scratch buffer and no memory pass per stage. Only the
+	recursive stages (Filter, FullWave) need their input in memory, so those are the points
+	where an expression is materialized with evaluate(). Each node is evaluated at the same
+	index, so output may alias any input. The evaluation order of + and * follows the
+	written expression, so a fused chain gives the same bits as the stage by stage version.
+*/
+/*===================================================================================*/
+	namespace Expression
+	{
+		template<class Derived>
+		struct Node
+		{
+			const Derived& self() const
+			{
+				return static_cast<const Derived&>(*this);
+			}
+		};
+
+		template<class T>
+		struct Signal : Node<Signal<T>>
+		{
+			using value_type = T;
+			explicit Signal(const T* data) : data(data) {}
+			T operator[](size_t i) const
+			{
+				return data[i];
+			}
+			const T* data;
+		};
+
+		template<class T>
+		struct Constant : Node<Constant<T>>
+		{
+			using value_type = T;
+			explicit Constant(T value) : value(value) {}
+			T operator[](size_t) const
+			{
+				return value;
+			}
+			T value;
+		};
+
+/*===================================================================================*/
+/*
+	[Struct] A gain moving linearly across the block, first + step * i (exactly first when
+	step is 0)
+*/
+		template<class T>
+		struct Ramp : Node<Ramp<T>>
+		{
+			using value_type = T;
+			Ramp(T first, T step) : first(first), step(step) {}
+			T operator[](size_t i) const
+			{
+				return first + step * static_cast<T>(i);
+			}
+			T first;
+			T step;
+		};
+
+		template<class Left, class Right, class Operation>
+		struct Binary : Node<Binary<Left, Right, Operation>>
+		{
+			using value_type = typename Left::value_type;
+			Binary(const Left& left, const Right& right, Operation operation = Operation()) : left(left), right(right), operation(operation) {}
+			value_type operator[](size_t i) const
+			{
+				return operation(left[i], right[i]);
+			}
+			Left left;
+			Right right;
+			Operation operation;
+		};
+
+		template<class Argument, class Operation>
+		struct Unary : Node<Unary<Argument, Operation>>
+		{
+			using value_type = typename Argument::value_type;
+			Unary(const Argument& argument, Operation operation) : argument(argument), operation(operation) {}
+			value_type operator[](size_t i) const
+			{
+				return operation(argument[i]);
+			}
+			Argument argument;
+			Operation operation;
+		};
+
+		struct Add
+		{
+			template<class T> T operator()(T a, T b) const { return a + b; }
+		};
+		struct Subtract
+		{
+			template<class T> T operator()(T a, T b) const { return a - b; }
+		};
+		struct Multiply
+		{
+			template<class T> T operator()(T a, T b) const { return a * b; }
+		};
+
+		template<class T>
+		Signal<T> signal(const T* data)
+		{
+			return Signal<T>(data);
+		}
+
+		template<class T>
+		Ramp<T> ramp(T first, T step)
+		{
+			return Ramp<T>(first, step);
+		}
+
+		template<class Left, class Right>
+		Binary<Left, Right, Add> operator+(const Node<Left>& left, const Node<Right>& right)
+		{
+			return { left.self(), right.self() };
+		}
+
+		template<class Left, class Right>
+		Binary<Left, Right, Subtract> operator-(const Node<Left>& left, const Node<Right>& right)
+		{
+			return { left.self(), right.self() };
+		}
+
+		template<class Left, class Right>
+		Binary<Left, Right, Multiply> operator*(const Node<Left>& left, const Node<Right>& right)
+		{
+			return { left.self(), right.self() };
+		}
+
+		template<class Right, class Scalar, class = std::enable_if_t<std::is_arithmetic<Scalar>::value>>
+		Binary<Constant<typename Right::value_type>, Right, Multiply> operator*(Scalar gain, const Node<Right>& right)
+		{
+			return { Constant<typename Right::value_type>(static_cast<typename Right::value_type>(gain)), right.self() };
+		}
+
+		template<class Left, class Scalar, class = std::enable_if_t<std::is_arithmetic<Scalar>::value>>
+		Binary<Left, Constant<typename Left::value_type>, Multiply> operator*(const Node<Left>& left, Scalar gain)
+		{
+			return { left.self(), Constant<typename Left::value_type>(static_cast<typename Left::value_type>(gain)) };
+		}
+
+		template<class Left, class Scalar, class = std::enable_if_t<std::is_arithmetic<Scalar>::value>>
+		Binary<Left, Constant<typename Left::value_type>, Add> operator+(const Node<Left>& left, Scalar offset)
+		{
+			return { left.self(), Constant<typename Left::value_type>(static_cast<typename Left::value_type>(offset)) };
+		}
+/*===================================================================================*/
+/*
+	[Functions] The FX stages as expression nodes (same arithmetic as the FX<T> block forms)
+*/
+		template<class Left, class Right>
+		Binary<Left, Right, Add> stereoToMono(const Node<Left>& left, const Node<Right>& right)
+		{
+			return left + right;
+		}
+
+		template<class First>
+		First accumulate(const Node<First>& first)
+		{
+			return first.self();
+		}
+
+		template<class First, class Second, class... Rest>
+		auto accumulate(const Node<First>& first, const Node<Second>& second, const Rest&... rest)
+		{
+			return accumulate(first + second, rest...);
+		}
+
+		template<class Argument>
+		auto fullwave(const Node<Argument>& argument)
+		{
+			using T = typename Argument::value_type;
+			auto operation = [](T x) { return static_cast<T>(std::fabs(x)); };
+			return Unary<Argument, decltype(operation)>(argument.self(), operation);
+		}
+
+		template<class Argument>
+		auto halfwave(const Node<Argument>& argument)
+		{
+			using T = typename Argument::value_type;
+			auto operation = [](T x) { return x < T(0) ? T(0) : x; };
+			return Unary<Argument, decltype(operation)>(argument.self(), operation);
+		}
+
+		template<class Argument>
+		auto zeroCrossing(const Node<Argument>& argument, typename Argument::value_type threshold, typename Argument::value_type mix)
+		{
+			using T = typename Argument::value_type;
+			auto operation = [threshold, mix](T x) { return std::fabs(x) < threshold ? T(0) : x * mix; };
+			return Unary<Argument, decltype(operation)>(argument.self(), operation);
+		}
+
+		template<Accuracy accuracy = Accuracy::High, class Argument>
+		auto arcTan(const Node<Argument>& argument, typename Argument::value_type alpha, typename Argument::value_type mix)
+		{
+			using T = typename Argument::value_type;
+			auto operation = [alpha, mix](T x) { return mix * FastMath<T>::template atan<accuracy>(alpha * x); };
+			return Unary<Argument, decltype(operation)>(argument.self(), operation);
+		}
+
+		template<Accuracy accuracy = Accuracy::High, class Argument>
+		auto arcTanH(const Node<Argument>& argument, typename Argument::value_type alpha, typename Argument::value_type mix)
+		{
+			using T = typename Argument::value_type;
+			auto operation = [alpha, mix](T x) { return mix * FastMath<T>::template atanh<accuracy>(alpha * x); };
+			return Unary<Argument, decltype(operation)>(argument.self(), operation);
+		}
+/*===================================================================================*/
+/*
+	[Function] Materializes an expression: output[i] = expression[i], one pass
+*/
+		template<class T, class Tree>
+		void evaluate(T* output, size_t numSamples, const Node<Tree>& expression)
+		{
+			const Tree& e = expression.self();
+			for (size_t i = 0; i < numSamples; i++)
+				output[i] = e[i];
+		}
+/*===================================================================================*/
+/*
+	[Function] output[i] += expression[i], one pass
+*/
+		template<class T, class Tree>
+		void accumulateInto(T* output, size_t numSamples, const Node<Tree>& expression)
+		{
+			const Tree& e = expression.self();
+			for (size_t i = 0; i < numSamples; i++)
+				output[i] += e[i];
+		}
+	}
+}
+#endif
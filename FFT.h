@@ -0,0 +1,169 @@
+#pragma once
+#ifndef AuxPort_FFT_H
+#define AuxPort_FFT_H
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] FFT of a real signal of size samples (a power of two, at least 4)
+
+	The size samples are packed into a complex FFT of half the size, which is run as an
+	iterative radix-2 transform over split real / imaginary arrays, and the two halves of
+	the spectrum are separated again afterwards. Spectra are size / 2 + 1 bins, also split.
+	Each stage's twiddles are stored contiguously, so the butterfly loops vectorize.
+	inverse(forward(x)) == x.
+*/
+/*===================================================================================*/
+	template<class T>
+	class RealFFT
+	{
+	public:
+		RealFFT() = default;
+/*===================================================================================*/
+/*
+	[Function] Builds the tables (allocates)
+*/
+		void prepare(size_t size)
+		{
+			const double pi = 3.14159265358979323846;
+			n = size;
+			half = size / 2;
+			twiddleRe.assign(half, T(0));
+			twiddleIm.assign(half, T(0));
+			for (size_t length = 2; length <= half; length <<= 1)
+			{
+				for (size_t j = 0; j < length / 2; j++)
+				{
+					const double angle = -2.0 * pi * static_cast<double>(j) / static_cast<double>(length);
+					twiddleRe[length / 2 - 1 + j] = static_cast<T>(std::cos(angle));
+					twiddleIm[length / 2 - 1 + j] = static_cast<T>(std::sin(angle));
+				}
+			}
+			splitCos.assign(half + 1, T(0));
+			splitSin.assign(half + 1, T(0));
+			for (size_t k = 0; k <= half; k++)
+			{
+				const double angle = 2.0 * pi * static_cast<double>(k) / static_cast<double>(n);
+				splitCos[k] = static_cast<T>(std::cos(angle));
+				splitSin[k] = static_cast<T>(std::sin(angle));
+			}
+			reversed.assign(half, 0);
+			size_t bits = 0;
+			while ((size_t(1) << bits) < half)
+				bits++;
+			for (size_t i = 0; i < half; i++)
+			{
+				size_t r = 0;
+				for (size_t b = 0; b < bits; b++)
+					r |= ((i >> b) & 1) << (bits - 1 - b);
+				reversed[i] = static_cast<uint32_t>(r);
+			}
+			re.assign(half, T(0));
+			im.assign(half, T(0));
+		}
+
+		size_t size() const
+		{
+			return n;
+		}
+
+		size_t bins() const
+		{
+			return half + 1;
+		}
+/*===================================================================================*/
+/*
+	[Function] size real samples -> bins() complex bins
+*/
+		void forward(const T* input, T* spectrumRe, T* spectrumIm)
+		{
+			for (size_t k = 0; k < half; k++)
+			{
+				re[reversed[k]] = input[2 * k];
+				im[reversed[k]] = input[2 * k + 1];
+			}
+			transform();
+			const T oneHalf = T(0.5);
+			for (size_t k = 0; k <= half; k++)
+			{
+				const size_t a = k == half ? 0 : k;
+				const size_t b = k == 0 ? 0 : half - k;
+				const T evenRe = oneHalf * (re[a] + re[b]);
+				const T evenIm = oneHalf * (im[a] - im[b]);
+				const T oddRe = oneHalf * (im[a] + im[b]);
+				const T oddIm = -oneHalf * (re[a] - re[b]);
+				spectrumRe[k] = evenRe + splitCos[k] * oddRe + splitSin[k] * oddIm;
+				spectrumIm[k] = evenIm + splitCos[k] * oddIm - splitSin[k] * oddRe;
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] bins() complex bins -> size real samples
+*/
+		void inverse(const T* spectrumRe, const T* spectrumIm, T* output)
+		{
+			const T oneHalf = T(0.5);
+			for (size_t k = 0; k < half; k++)
+			{
+				const size_t b = half - k;
+				const T evenRe = oneHalf * (spectrumRe[k] + spectrumRe[b]);
+				const T evenIm = oneHalf * (spectrumIm[k] - spectrumIm[b]);
+				const T differenceRe = oneHalf * (spectrumRe[k] - spectrumRe[b]);
+				const T differenceIm = oneHalf * (spectrumIm[k] + spectrumIm[b]);
+				const T oddRe = differenceRe * splitCos[k] - differenceIm * splitSin[k];
+				const T oddIm = differenceRe * splitSin[k] + differenceIm * splitCos[k];
+				// conjugated on the way in and out, so the forward transform runs the inverse
+				re[reversed[k]] = evenRe - oddIm;
+				im[reversed[k]] = -(evenIm + oddRe);
+			}
+			transform();
+			const T scale = T(1) / static_cast<T>(half);
+			for (size_t k = 0; k < half; k++)
+			{
+				output[2 * k] = re[k] * scale;
+				output[2 * k + 1] = -im[k] * scale;
+			}
+		}
+	private:
+		void transform()
+		{
+			for (size_t length = 2; length <= half; length <<= 1)
+			{
+				const size_t span = length / 2;
+				const T* wRe = twiddleRe.data() + span - 1;
+				const T* wIm = twiddleIm.data() + span - 1;
+				for (size_t start = 0; start < half; start += length)
+				{
+					T* topRe = re.data() + start;
+					T* topIm = im.data() + start;
+					T* bottomRe = topRe + span;
+					T* bottomIm = topIm + span;
+					for (size_t j = 0; j < span; j++)
+					{
+						const T tRe = bottomRe[j] * wRe[j] - bottomIm[j] * wIm[j];
+						const T tIm = bottomRe[j] * wIm[j] + bottomIm[j] * wRe[j];
+						bottomRe[j] = topRe[j] - tRe;
+						bottomIm[j] = topIm[j] - tIm;
+						topRe[j] += tRe;
+						topIm[j] += tIm;
+					}
+				}
+			}
+		}
+
+		size_t n = 0;
+		size_t half = 0;
+		std::vector<T> twiddleRe;
+		std::vector<T> twiddleIm;
+		std::vector<T> splitCos;
+		std::vector<T> splitSin;
+		std::vector<uint32_t> reversed;
+		std::vector<T> re;
+		std::vector<T> im;
+	};
+}
+#endif
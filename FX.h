@@ -1,49 +1,499 @@
 #pragma once
 #ifndef FX_H
 #define FX_H
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
+#include "CoefficientCache.h"
+#include "Dispatch.h"
+#include "Snapshot.h"
 namespace AuxPort
 {
 
 /*===================================================================================*/
 /*
-	[Class] Abstraction over AudioFilter class in FXObjects [Don't Mess with it]
+	[Class] Biquad with FXObjects' AudioFilter coefficient designs [Don't Mess with it]
+
+	Coefficients are designed in double and stored as bufferType, so the sample loop runs
+	entirely in bufferType. Each channel has its own state. Supported algorithms: kLPF1,
+	kHPF1, kLPF2, kHPF2, kBPF2, kBSF2, kButterLPF2, kButterHPF2, kButterBPF2, kButterBSF2,
+	kLWRLPF2 and kLWRHPF2; anything else passes audio through unchanged.
 */
 /*===================================================================================*/
 	template<class bufferType, class effectType>
 	class Filter
 	{
 	public:
+		static constexpr int maxChannels = 2;
 		Filter() = default;
 		Filter(const Filter& filter) = default;
 		void setFilterType(const filterAlgorithm& type)
 		{
+			if (designed && filterParameters.algorithm == type)
+				return;
 			filterParameters.algorithm = type;
+			design();
 		}
 		void setParameters(const effectType& centerFrequency, const effectType& QFactor, const effectType& boostCut)
 		{
+			if (designed && filterParameters.fc == centerFrequency && filterParameters.Q == QFactor && filterParameters.boostCut_dB == boostCut)
+				return;
 			filterParameters.Q = QFactor;
 			filterParameters.fc = centerFrequency;
 			filterParameters.boostCut_dB = boostCut;
-			filter.setParameters(filterParameters);
+			design();
+		}
+/*===================================================================================*/
+/*
+	[Function] Designing in two halves, for design off the audio thread: keyFor() says what
+	this filter would be designed for with the given parameters (its own type and rate),
+	design() runs anywhere, and setDesign() installs the result without computing anything.
+	setDesign() refuses a design for another type or rate (one made before a reset()).
+*/
+		CoefficientKey keyFor(const effectType& centerFrequency, const effectType& QFactor, const effectType& boostCut) const
+		{
+			CoefficientKey designKey = key();
+			designKey.fc = centerFrequency;
+			designKey.Q = QFactor;
+			designKey.boostCut = boostCut;
+			return designKey;
 		}
-		bufferType process(const bufferType& frame)
+
+		static void design(const CoefficientKey& designKey, double* c)
+		{
+			CoefficientCache::shared().design(designKey, &Filter::compute, c);
+		}
+
+		bool setDesign(const CoefficientKey& designKey, const double* c)
 		{
-			return filter.processAudioSample(frame);
+			if (!designed || designKey.algorithm != static_cast<int32_t>(filterParameters.algorithm) || designKey.sampleRate != sampleRate)
+				return false;
+			filterParameters.fc = designKey.fc;
+			filterParameters.Q = designKey.Q;
+			filterParameters.boostCut_dB = designKey.boostCut;
+			for (int i = 0; i < 5; i++)
+				designedCoefficients[i] = static_cast<bufferType>(c[i]);
+			applyGain();
+			return true;
+		}
+/*===================================================================================*/
+/*
+	[Function] The key of the design in use
+*/
+		CoefficientKey key() const
+		{
+			CoefficientKey designKey;
+			designKey.algorithm = static_cast<int32_t>(filterParameters.algorithm);
+			designKey.fc = filterParameters.fc;
+			designKey.Q = filterParameters.Q;
+			designKey.boostCut = filterParameters.boostCut_dB;
+			designKey.sampleRate = sampleRate;
+			return designKey;
+		}
+/*===================================================================================*/
+/*
+	[Function] Control rate redesign on the audio thread (a modulated cutoff): computes the
+	coefficients directly instead of through the CoefficientCache, so it never takes the
+	cache's lock and a sweep doesn't flood the cache with one-off designs. Keeps the state.
+*/
+		bool designNow(const CoefficientKey& designKey)
+		{
+			double c[5];
+			compute(designKey, c);
+			return setDesign(designKey, c);
+		}
+/*===================================================================================*/
+/*
+	[Function] Scales the numerator, i.e. the filter now computes gain * H(z). Because only
+	a0..a2 change, this is exactly a gain on the input, so it can change at any time without
+	touching the state. Costs three multiplies; no redesign.
+*/
+		void setGain(const bufferType& newGain)
+		{
+			if (gain == newGain)
+				return;
+			gain = newGain;
+			applyGain();
+		}
+		bufferType process(const bufferType& frame, int channel = 0)
+		{
+			State& z = state[channel];
+			const bufferType* c = coefficients;
+			bufferType y = c[0] * frame + z.z1;
+			z.z1 = c[1] * frame - c[3] * y + z.z2;
+			z.z2 = c[2] * frame - c[4] * y;
+			return y;
+		}
+		void process(const bufferType* input, bufferType* output, size_t numSamples, int channel = 0)
+		{
+			State& z = state[channel];
+			Dispatch<bufferType>::biquad(input, output, numSamples, coefficients, z.z1, z.z2);
+		}
+		void process(bufferType* buffer, size_t numSamples, int channel = 0)
+		{
+			process(buffer, buffer, numSamples, channel);
+		}
+/*===================================================================================*/
+/*
+	[Function] Clears one channel's state (or all with channel = -1) without redesigning
+*/
+		void clearState(int channel = -1)
+		{
+			for (int i = 0; i < maxChannels; i++)
+			{
+				if (channel < 0 || channel == i)
+					state[i] = State();
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Redesigns for a new sample rate without touching the state (no-op if unchanged)
+*/
+		void setSampleRate(const double& newSampleRate)
+		{
+			if (designed && sampleRate == newSampleRate)
+				return;
+			sampleRate = newSampleRate;
+			design();
+		}
+		void reset(const double& newSampleRate)
+		{
+			sampleRate = newSampleRate;
+			for (State& z : state)
+				z = State();
+			design();
+		}
+/*===================================================================================*/
+/*
+	[Function] Writes the design (parameters, rate, gain, coefficients) and every channel's
+	state; restore() puts it back as is, without redesigning
+*/
+		void save(StateWriter& writer) const
+		{
+			writer.write(static_cast<int32_t>(filterParameters.algorithm));
+			writer.write(filterParameters.fc);
+			writer.write(filterParameters.Q);
+			writer.write(filterParameters.boostCut_dB);
+			writer.write(sampleRate);
+			writer.write(designed);
+			writer.write(gain);
+			writer.write(designedCoefficients, 5);
+			writer.write(coefficients, 5);
+			writer.write(state, maxChannels);
+		}
+
+		bool restore(StateReader& reader)
+		{
+			int32_t algorithm = 0;
+			reader.read(algorithm);
+			filterParameters.algorithm = static_cast<filterAlgorithm>(algorithm);
+			reader.read(filterParameters.fc);
+			reader.read(filterParameters.Q);
+			reader.read(filterParameters.boostCut_dB);
+			reader.read(sampleRate);
+			reader.read(designed);
+			reader.read(gain);
+			reader.read(designedCoefficients, 5);
+			reader.read(coefficients, 5);
+			reader.read(state, maxChannels);
+			return reader.good();
 		}
 		~Filter() = default;
 	private:
-		AudioFilter filter;
+		struct State
+		{
+			bufferType z1 = 0;
+			bufferType z2 = 0;
+		};
+		void applyGain()
+		{
+			for (int i = 0; i < 3; i++)
+				coefficients[i] = gain * designedCoefficients[i];
+			coefficients[3] = designedCoefficients[3];
+			coefficients[4] = designedCoefficients[4];
+		}
+/*===================================================================================*/
+/*
+	[Function] Takes the coefficients from the process wide CoefficientCache, so instances
+	with the same settings design them once between them
+*/
+		void design()
+		{
+			double c[5];
+			design(key(), c);
+			for (int i = 0; i < 5; i++)
+				designedCoefficients[i] = static_cast<bufferType>(c[i]);
+			applyGain();
+			designed = true;
+		}
+
+
+		static void compute(const CoefficientKey& designKey, double* c)
+		{
+			const filterAlgorithm algorithm = static_cast<filterAlgorithm>(designKey.algorithm);
+			const double sampleRate = designKey.sampleRate;
+			// Keep fc below Nyquist so a low host rate can't fold tan() over
+			const double fc = std::fmin(designKey.fc, 0.49 * sampleRate);
+			const double Q = designKey.Q;
+			c[0] = 1.0;
+			c[1] = c[2] = c[3] = c[4] = 0.0;
+			switch (algorithm)
+			{
+			case filterAlgorithm::kLPF1:
+			case filterAlgorithm::kHPF1:
+			{
+				double theta = 2.0 * kPi * fc / sampleRate;
+				double gamma = cos(theta) / (1.0 + sin(theta));
+				double sign = algorithm == filterAlgorithm::kLPF1 ? 1.0 : -1.0;
+				double gain = algorithm == filterAlgorithm::kLPF1 ? (1.0 - gamma) / 2.0 : (1.0 + gamma) / 2.0;
+				c[0] = gain;
+				c[1] = sign * gain;
+				c[3] = -gamma;
+				break;
+			}
+			case filterAlgorithm::kLPF2:
+			case filterAlgorithm::kHPF2:
+			{
+				double theta = 2.0 * kPi * fc / sampleRate;
+				double d = 1.0 / Q;
+				double beta = 0.5 * (1.0 - (d / 2.0) * sin(theta)) / (1.0 + (d / 2.0) * sin(theta));
+				double gamma = (0.5 + beta) * cos(theta);
+				bool lowPass = algorithm == filterAlgorithm::kLPF2;
+				double alpha = lowPass ? (0.5 + beta - gamma) / 2.0 : (0.5 + beta + gamma) / 2.0;
+				c[0] = alpha;
+				c[1] = lowPass ? 2.0 * alpha : -2.0 * alpha;
+				c[2] = alpha;
+				c[3] = -2.0 * gamma;
+				c[4] = 2.0 * beta;
+				break;
+			}
+			case filterAlgorithm::kBPF2:
+			case filterAlgorithm::kBSF2:
+			{
+				double K = tan(kPi * fc / sampleRate);
+				double delta = K * K * Q + K + Q;
+				if (algorithm == filterAlgorithm::kBPF2)
+				{
+					c[0] = K / delta;
+					c[1] = 0.0;
+					c[2] = -K / delta;
+				}
+				else
+				{
+					c[0] = Q * (1.0 + K * K) / delta;
+					c[1] = 2.0 * Q * (K * K - 1.0) / delta;
+					c[2] = c[0];
+				}
+				c[3] = 2.0 * Q * (K * K - 1.0) / delta;
+				c[4] = (K * K * Q - K + Q) / delta;
+				break;
+			}
+			case filterAlgorithm::kButterLPF2:
+			{
+				double C = 1.0 / tan(kPi * fc / sampleRate);
+				c[0] = 1.0 / (1.0 + kSqrtTwo * C + C * C);
+				c[1] = 2.0 * c[0];
+				c[2] = c[0];
+				c[3] = 2.0 * c[0] * (1.0 - C * C);
+				c[4] = c[0] * (1.0 - kSqrtTwo * C + C * C);
+				break;
+			}
+			case filterAlgorithm::kButterHPF2:
+			{
+				double C = tan(kPi * fc / sampleRate);
+				c[0] = 1.0 / (1.0 + kSqrtTwo * C + C * C);
+				c[1] = -2.0 * c[0];
+				c[2] = c[0];
+				c[3] = 2.0 * c[0] * (C * C - 1.0);
+				c[4] = c[0] * (1.0 - kSqrtTwo * C + C * C);
+				break;
+			}
+			case filterAlgorithm::kButterBPF2:
+			case filterAlgorithm::kButterBSF2:
+			{
+				double deltaC = kPi * (fc / Q) / sampleRate;
+				double D = 2.0 * cos(2.0 * kPi * fc / sampleRate);
+				if (algorithm == filterAlgorithm::kButterBPF2)
+				{
+					double C = 1.0 / tan(deltaC);
+					c[0] = 1.0 / (1.0 + C);
+					c[1] = 0.0;
+					c[2] = -c[0];
+					c[3] = -c[0] * (C * D);
+					c[4] = c[0] * (C - 1.0);
+				}
+				else
+				{
+					double C = tan(deltaC);
+					c[0] = 1.0 / (1.0 + C);
+					c[1] = -c[0] * D;
+					c[2] = c[0];
+					c[3] = -c[0] * D;
+					c[4] = c[0] * (1.0 - C);
+				}
+				break;
+			}
+			case filterAlgorithm::kLWRLPF2:
+			case filterAlgorithm::kLWRHPF2:
+			{
+				double omega = kPi * fc;
+				double k = omega / tan(kPi * fc / sampleRate);
+				double denominator = k * k + omega * omega + 2.0 * k * omega;
+				double numerator = algorithm == filterAlgorithm::kLWRLPF2 ? omega * omega : k * k;
+				double sign = algorithm == filterAlgorithm::kLWRLPF2 ? 1.0 : -1.0;
+				c[0] = numerator / denominator;
+				c[1] = sign * 2.0 * numerator / denominator;
+				c[2] = c[0];
+				c[3] = (-2.0 * k * k + 2.0 * omega * omega) / denominator;
+				c[4] = (-2.0 * k * omega + k * k + omega * omega) / denominator;
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
 		AudioFilterParameters filterParameters;
+		double sampleRate = 44100.0;
+		bool designed = false;
+		bufferType gain = 1;
+		bufferType designedCoefficients[5] = { 1, 0, 0, 0, 0 };	// a0, a1, a2, b1, b2
+		bufferType coefficients[5] = { 1, 0, 0, 0, 0 };			// numerator scaled by gain
+		State state[maxChannels];
+	};
 
+/*===================================================================================*/
+/*
+	[Class] Stereo Linkwitz-Riley crossover: the low and high band of both channels from one
+	shared state variable structure (Kernel::crossover), instead of a low pass and a high
+	pass each running over the input
+
+	Order 2 (12 dB/oct) costs one SVF pass per channel, order 4 (24 dB/oct) two; either way
+	the bands sum to an allpass, so recombining them keeps the magnitude flat. The design is
+	one tan(), cheap enough to redo on the audio thread when the frequency moves. setGain()
+	scales the input, as Filter::setGain() scales the numerator.
+*/
+/*===================================================================================*/
+	template<class bufferType>
+	class Crossover
+	{
+	public:
+		Crossover() = default;
+		void setOrder(int newOrder)
+		{
+			newOrder = newOrder == 4 ? 4 : 2;
+			if (newOrder == order)
+				return;
+			order = newOrder;
+			clearState();
+			design();
+		}
+		void setFrequency(double newFrequency)
+		{
+			if (frequency == newFrequency)
+				return;
+			frequency = newFrequency;
+			design();
+		}
+		void setSampleRate(double newSampleRate)
+		{
+			if (sampleRate == newSampleRate)
+				return;
+			sampleRate = newSampleRate;
+			design();
+		}
+		void reset(double newSampleRate)
+		{
+			sampleRate = newSampleRate;
+			clearState();
+			design();
+		}
+		void setGain(const bufferType& newGain)
+		{
+			gain = newGain;
+		}
+		void clearState()
+		{
+			for (bufferType& value : state)
+				value = 0;
+		}
+/*===================================================================================*/
+/*
+	[Function] Splits numSamples of left/right into the four band buffers
+*/
+		void process(const bufferType* left, const bufferType* right, bufferType* lowLeft, bufferType* lowRight, bufferType* highLeft, bufferType* highRight, size_t numSamples)
+		{
+			Dispatch<bufferType>::crossover(left, right, lowLeft, lowRight, highLeft, highRight, numSamples, coefficients, state, order, gain);
+		}
+		int getOrder() const
+		{
+			return order;
+		}
+		double getFrequency() const
+		{
+			return frequency;
+		}
+		void save(StateWriter& writer) const
+		{
+			writer.write(static_cast<int32_t>(order));
+			writer.write(frequency);
+			writer.write(sampleRate);
+			writer.write(gain);
+			writer.write(coefficients, 4);
+			writer.write(state, 8);
+		}
+		bool restore(StateReader& reader)
+		{
+			int32_t savedOrder = 2;
+			reader.read(savedOrder);
+			order = savedOrder == 4 ? 4 : 2;
+			reader.read(frequency);
+			reader.read(sampleRate);
+			reader.read(gain);
+			reader.read(coefficients, 4);
+			reader.read(state, 8);
+			return reader.good();
+		}
+	private:
+/*===================================================================================*/
+/*
+	[Function] SVF coefficients a1, a2, a3 and damping k = 1 / Q: Q = 0.5 for the single
+	LR2 stage, Butterworth for the two LR4 stages
+*/
+		void design()
+		{
+			const double fc = std::fmin(std::fmax(frequency, 1.0), 0.49 * sampleRate);
+			const double g = std::tan(kPi * fc / sampleRate);
+			const double k = order == 4 ? kSqrtTwo : 2.0;
+			const double a1 = 1.0 / (1.0 + g * (g + k));
+			coefficients[0] = static_cast<bufferType>(a1);
+			coefficients[1] = static_cast<bufferType>(g * a1);
+			coefficients[2] = static_cast<bufferType>(g * g * a1);
+			coefficients[3] = static_cast<bufferType>(k);
+		}
+
+		int order = 2;
+		double frequency = 1000.0;
+		double sampleRate = 44100.0;
+		bufferType gain = 1;
+		bufferType coefficients[4] = {};
+		bufferType state[8] = {};		// ic1, ic2 per channel for each of the two stages
 	};
 
+/*===================================================================================*/
+/*
+	[Class] Zero crossing integrator: accumulates the previous input and restarts at every
+	negative to positive crossing. The block process() is the segmented scan in Kernels.h
+	and matches the per-sample process() exactly.
+*/
+/*===================================================================================*/
 	template<class bufferType>
 	class FullWave
 	{
 	public:
 		FullWave() = default;
 		~FullWave() = default;
-		double process(const bufferType& frame,bool toProcess)
+		bufferType process(const bufferType& frame,bool toProcess)
 		{
 			if (toProcess)
 			{
@@ -65,9 +515,139 @@ namespace AuxPort
 			else
 				return frame;
 		}
+		void process(bufferType* buffer, size_t numSamples, bool toProcess)
+		{
+			if (toProcess)
+				Dispatch<bufferType>::fullWave(buffer, numSamples, previousFrame, previousProcessedFrame);
+		}
+		void reset()
+		{
+			previousFrame = 0;
+			previousProcessedFrame = 0;
+		}
+		void save(StateWriter& writer) const
+		{
+			writer.write(previousFrame);
+			writer.write(previousProcessedFrame);
+		}
+		bool restore(StateReader& reader)
+		{
+			reader.read(previousFrame);
+			reader.read(previousProcessedFrame);
+			return reader.good();
+		}
 	private:
-		bufferType previousFrame;
-		bufferType previousProcessedFrame;
+		bufferType previousFrame = 0;
+		bufferType previousProcessedFrame = 0;
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Control rate envelope follower (a sidechain detector)
+
+	accumulate() sums the squares of (left + right) / 2 over a block, split over eight
+	accumulators so it vectorizes, and may be called any number of times per control
+	period. update() turns the period's RMS into the level, moving towards it once with the
+	attack or release time constant for that many samples. The level is scaled so a full
+	scale sine reads 1 and is clamped to [0, 1]; it settles to exactly 0 in silence.
+*/
+/*===================================================================================*/
+	template<class bufferType>
+	class EnvelopeFollower
+	{
+	public:
+		EnvelopeFollower() = default;
+		void reset(double newSampleRate)
+		{
+			sampleRate = newSampleRate;
+			level = 0;
+			clearPeriod();
+		}
+		void setTimes(double attackMs, double releaseMs)
+		{
+			attackSamples = std::fmax(attackMs, 0.01) * 0.001 * sampleRate;
+			releaseSamples = std::fmax(releaseMs, 0.01) * 0.001 * sampleRate;
+		}
+/*===================================================================================*/
+/*
+	[Function] Adds a block of sidechain to the period; left = nullptr is silence
+*/
+		void accumulate(const bufferType* left, const bufferType* right, size_t numSamples)
+		{
+			count += numSamples;
+			if (!left)
+				return;
+			const bufferType* other = right ? right : left;
+			size_t i = 0;
+			for (; i + 8 <= numSamples; i += 8)
+			{
+				for (size_t lane = 0; lane < 8; lane++)
+				{
+					const bufferType mono = left[i + lane] + other[i + lane];
+					sums[lane] += mono * mono;
+				}
+			}
+			for (; i < numSamples; i++)
+			{
+				const bufferType mono = left[i] + other[i];
+				sums[0] += mono * mono;
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Ends the period and returns the new level
+*/
+		bufferType update()
+		{
+			if (count == 0)
+				return level;
+			bufferType sum = 0;
+			for (size_t lane = 0; lane < 8; lane++)
+				sum += sums[lane];
+			// (l + r) / 2 and the sine's sqrt(2): the mean square of l + r, times 2 / 4
+			bufferType target = std::sqrt(sum / static_cast<bufferType>(2 * count));
+			target = target > bufferType(1) ? bufferType(1) : target;
+			const double time = target > level ? attackSamples : releaseSamples;
+			const bufferType coefficient = static_cast<bufferType>(1.0 - std::exp(-static_cast<double>(count) / time));
+			level += coefficient * (target - level);
+			if (level < bufferType(1e-5) && target == bufferType(0))
+				level = 0;
+			clearPeriod();
+			return level;
+		}
+		bufferType getLevel() const
+		{
+			return level;
+		}
+		void save(StateWriter& writer) const
+		{
+			writer.write(level);
+			writer.write(sums, 8);
+			writer.write(static_cast<uint64_t>(count));
+		}
+		bool restore(StateReader& reader)
+		{
+			uint64_t savedCount = 0;
+			reader.read(level);
+			reader.read(sums, 8);
+			reader.read(savedCount);
+			count = static_cast<size_t>(savedCount);
+			return reader.good();
+		}
+	private:
+		void clearPeriod()
+		{
+			for (size_t lane = 0; lane < 8; lane++)
+				sums[lane] = 0;
+			count = 0;
+		}
+
+		double sampleRate = 44100.0;
+		double attackSamples = 441.0;
+		double releaseSamples = 4410.0;
+		bufferType level = 0;
+		bufferType sums[8] = {};
+		size_t count = 0;
 	};
 	
 
@@ -75,7 +655,7 @@ namespace AuxPort
 	class FX
 	{
 	public:
-		static void DCOffset(bufferType& frame, const double& offset, bool state, const double& mix)
+		static void DCOffset(bufferType& frame, const bufferType& offset, bool state, const bufferType& mix)
 		{
 			if (state)
 			{
@@ -85,21 +665,21 @@ namespace AuxPort
 
 		}
 
-		static void PreGain(bufferType& frame, const float& preGain)
+		static void PreGain(bufferType& frame, const bufferType& preGain)
 		{
 			frame *= preGain;
 		}
 
-		static void PostGain(bufferType& frame, const double& postGain)
+		static void PostGain(bufferType& frame, const bufferType& postGain)
 		{
 			frame *= postGain;
 		}
 
-		static void ZeroCrossing(bufferType& frame, const double& threshold, bool state, const double& mix)
+		static void ZeroCrossing(bufferType& frame, const bufferType& threshold, bool state, const bufferType& mix)
 		{
 			if (state)
 			{
-				if (abs(frame) < threshold)
+				if (std::abs(frame) < threshold)
 				{
 					frame = 0;
 				}
@@ -111,16 +691,16 @@ namespace AuxPort
 
 		}
 
-		static void ArcTan1(bufferType& frame, const double& alpha, bool state, const double& mix)
+		static void ArcTan1(bufferType& frame, const bufferType& alpha, bool state, const bufferType& mix)
 		{
 			if (state)
-				frame = mix * atan(alpha * frame);
+				frame = mix * std::atan(alpha * frame);
 		}
 
-		static void ArcTan2(bufferType& frame, const double& alpha, bool state, const double& mix)
+		static void ArcTan2(bufferType& frame, const bufferType& alpha, bool state, const bufferType& mix)
 		{
 			if (state)
-				frame = mix * (2 / kPi) * atan(alpha * frame);
+				frame = mix * static_cast<bufferType>(2 / kPi) * std::atan(alpha * frame);
 		}
 
 		static void Fullwave(bufferType& frame, bool state)
@@ -141,26 +721,235 @@ namespace AuxPort
 			}
 		}
 
-		static void ArcTanH(bufferType& frame, const double& alpha, bool state, const double& mix)
+		static void ArcTanH(bufferType& frame, const bufferType& alpha, bool state, const bufferType& mix)
 		{
 			if (state)
 			{
-				frame = mix * atanh(alpha * frame);
+				frame = mix * std::atanh(alpha * frame);
+			}
+
+		}
+
+		/*
+			Block versions: numSamples contiguous samples, out-of-place (input -> output, which
+			may alias) or in place. The enable state is a template parameter, so a disabled
+			stage is a copy (or nothing, in place) and an enabled one is a branchless loop the
+			compiler vectorizes. The runtime bool overloads only pick the specialization once
+			per block. The arc tangent shapers use FastMath instead of libm (see FastMath.h for
+			the error of each tier) through the dispatched kernel table in Dispatch.h.
+		*/
+		template<bool state>
+		static void DCOffset(const bufferType* input, bufferType* output, size_t numSamples, bufferType offset, bufferType mix)
+		{
+			if constexpr (state)
+			{
+				for (size_t i = 0; i < numSamples; i++)
+					output[i] = (input[i] + offset) * mix;
+			}
+			else
+				copy(input, output, numSamples);
+		}
+
+		template<bool state>
+		static void ZeroCrossing(const bufferType* input, bufferType* output, size_t numSamples, bufferType threshold, bufferType mix)
+		{
+			if constexpr (state)
+			{
+				for (size_t i = 0; i < numSamples; i++)
+				{
+					bufferType x = input[i];
+					output[i] = std::fabs(x) < threshold ? bufferType(0) : x * mix;
+				}
+			}
+			else
+				copy(input, output, numSamples);
+		}
+
+		template<bool state>
+		static void Fullwave(const bufferType* input, bufferType* output, size_t numSamples)
+		{
+			if constexpr (state)
+			{
+				for (size_t i = 0; i < numSamples; i++)
+					output[i] = std::fabs(input[i]);
+			}
+			else
+				copy(input, output, numSamples);
+		}
+
+		template<bool state>
+		static void Halfwave(const bufferType* input, bufferType* output, size_t numSamples)
+		{
+			if constexpr (state)
+			{
+				for (size_t i = 0; i < numSamples; i++)
+				{
+					bufferType x = input[i];
+					output[i] = x < bufferType(0) ? bufferType(0) : x;
+				}
 			}
+			else
+				copy(input, output, numSamples);
+		}
 
+		template<bool state>
+		static void ArcTan1(const bufferType* input, bufferType* output, size_t numSamples, bufferType alpha, bufferType mix, Accuracy accuracy = Accuracy::High)
+		{
+			copy(input, output, numSamples);
+			if constexpr (state)
+				Dispatch<bufferType>::arcTan(output, numSamples, alpha, mix, accuracy);
 		}
 
-		static bufferType accumulate(const std::vector<bufferType> items)
+		template<bool state>
+		static void ArcTan2(const bufferType* input, bufferType* output, size_t numSamples, bufferType alpha, bufferType mix, Accuracy accuracy = Accuracy::High)
+		{
+			copy(input, output, numSamples);
+			if constexpr (state)
+				Dispatch<bufferType>::arcTan(output, numSamples, alpha, mix * static_cast<bufferType>(2 / kPi), accuracy);
+		}
+
+		template<bool state>
+		static void ArcTanH(const bufferType* input, bufferType* output, size_t numSamples, bufferType alpha, bufferType mix, Accuracy accuracy = Accuracy::High)
+		{
+			copy(input, output, numSamples);
+			if constexpr (state)
+				Dispatch<bufferType>::arcTanH(output, numSamples, alpha, mix, accuracy);
+		}
+
+		static void PreGain(const bufferType* input, bufferType* output, size_t numSamples, bufferType preGain)
+		{
+			for (size_t i = 0; i < numSamples; i++)
+				output[i] = input[i] * preGain;
+		}
+
+		static void PostGain(const bufferType* input, bufferType* output, size_t numSamples, bufferType postGain)
+		{
+			PreGain(input, output, numSamples, postGain);
+		}
+
+		static void stereoToMono(const bufferType* left, const bufferType* right, bufferType* output, size_t numSamples)
+		{
+			for (size_t i = 0; i < numSamples; i++)
+				output[i] = left[i] + right[i];
+		}
+
+		/*
+			In place forms of the above
+		*/
+		template<bool state>
+		static void DCOffset(bufferType* buffer, size_t numSamples, bufferType offset, bufferType mix)
+		{
+			DCOffset<state>(buffer, buffer, numSamples, offset, mix);
+		}
+
+		template<bool state>
+		static void ZeroCrossing(bufferType* buffer, size_t numSamples, bufferType threshold, bufferType mix)
+		{
+			ZeroCrossing<state>(buffer, buffer, numSamples, threshold, mix);
+		}
+
+		template<bool state>
+		static void Fullwave(bufferType* buffer, size_t numSamples)
+		{
+			Fullwave<state>(buffer, buffer, numSamples);
+		}
+
+		template<bool state>
+		static void Halfwave(bufferType* buffer, size_t numSamples)
+		{
+			Halfwave<state>(buffer, buffer, numSamples);
+		}
+
+		template<bool state>
+		static void ArcTan1(bufferType* buffer, size_t numSamples, bufferType alpha, bufferType mix, Accuracy accuracy = Accuracy::High)
+		{
+			ArcTan1<state>(buffer, buffer, numSamples, alpha, mix, accuracy);
+		}
+
+		template<bool state>
+		static void ArcTan2(bufferType* buffer, size_t numSamples, bufferType alpha, bufferType mix, Accuracy accuracy = Accuracy::High)
+		{
+			ArcTan2<state>(buffer, buffer, numSamples, alpha, mix, accuracy);
+		}
+
+		template<bool state>
+		static void ArcTanH(bufferType* buffer, size_t numSamples, bufferType alpha, bufferType mix, Accuracy accuracy = Accuracy::High)
+		{
+			ArcTanH<state>(buffer, buffer, numSamples, alpha, mix, accuracy);
+		}
+
+		static void PreGain(bufferType* buffer, size_t numSamples, bufferType preGain)
+		{
+			PreGain(buffer, buffer, numSamples, preGain);
+		}
+
+		static void PostGain(bufferType* buffer, size_t numSamples, bufferType postGain)
+		{
+			PreGain(buffer, buffer, numSamples, postGain);
+		}
+
+		/*
+			Block forms with the state decided at runtime, once per block
+		*/
+		static void DCOffset(bufferType* buffer, const size_t& numSamples, const bufferType& offset, bool state, const bufferType& mix)
+		{
+			if (state)
+				DCOffset<true>(buffer, numSamples, offset, mix);
+		}
+
+		static void ZeroCrossing(bufferType* buffer, const size_t& numSamples, const bufferType& threshold, bool state, const bufferType& mix)
+		{
+			if (state)
+				ZeroCrossing<true>(buffer, numSamples, threshold, mix);
+		}
+
+		static void Fullwave(bufferType* buffer, const size_t& numSamples, bool state)
+		{
+			if (state)
+				Fullwave<true>(buffer, numSamples);
+		}
+
+		static void Halfwave(bufferType* buffer, const size_t& numSamples, bool state)
+		{
+			if (state)
+				Halfwave<true>(buffer, numSamples);
+		}
+
+		static void ArcTan1(bufferType* buffer, const size_t& numSamples, const bufferType& alpha, bool state, const bufferType& mix, Accuracy accuracy = Accuracy::High)
+		{
+			if (state)
+				ArcTan1<true>(buffer, numSamples, alpha, mix, accuracy);
+		}
+
+		static void ArcTan2(bufferType* buffer, const size_t& numSamples, const bufferType& alpha, bool state, const bufferType& mix, Accuracy accuracy = Accuracy::High)
+		{
+			if (state)
+				ArcTan2<true>(buffer, numSamples, alpha, mix, accuracy);
+		}
+
+		static void ArcTanH(bufferType* buffer, const size_t& numSamples, const bufferType& alpha, bool state, const bufferType& mix, Accuracy accuracy = Accuracy::High)
+		{
+			if (state)
+				ArcTanH<true>(buffer, numSamples, alpha, mix, accuracy);
+		}
+
+		static bufferType accumulate(std::initializer_list<bufferType> items)
 		{
 			bufferType sum = 0;
-			for (size_t i = 0; i < items.size(); i++)
-				sum += items[i];
+			for (const bufferType& item : items)
+				sum += item;
 			return sum;
 		}
 		static bufferType stereoToMono(const bufferType& left, const bufferType& right)
 		{
 			return left + right;
 		}
+	private:
+		static void copy(const bufferType* input, bufferType* output, size_t numSamples)
+		{
+			if (input != output)
+				std::memmove(output, input, numSamples * sizeof(bufferType));
+		}
 	};
 }
 #endif
\ No newline at end of file
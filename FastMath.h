@@ -0,0 +1,172 @@
+#pragma once
+#ifndef AuxPort_FastMath_H
+#define AuxPort_FastMath_H
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__GNUC__)
+#define AUXPORT_KERNEL __attribute__((always_inline)) inline
+#else
+#define AUXPORT_KERNEL __forceinline
+#endif
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Enum] Accuracy tiers for the FastMath approximations
+
+	Max absolute error against double precision libm, rounded up from a sweep of every 7th
+	float bit pattern for atan (all finite inputs) and every 3rd for atanh (inputs in
+	(-1, 1)); tests/fastmath_test.cpp checks them:
+
+				T = float				T = double
+				atan		atanh		atan		atanh
+	Low			6.1e-4		2.5e-6		6.1e-4		2.0e-6
+	Medium		1.2e-5		5.6e-7		1.2e-5		1.1e-8
+	High		1.8e-7		5.4e-7		3.8e-8		6.5e-11
+
+	For float, High is within two ulps of the result; atanh reaches +-8.7 near the clamp,
+	which is why its float error floor sits above atan's.
+
+	NOTE: gcc only if-converts the selects below with -fno-trapping-math (or -ffast-math);
+	without it the block loops are still branch free, just scalar.
+*/
+/*===================================================================================*/
+	enum class Accuracy
+	{
+		Low, Medium, High
+	};
+
+	template<class T> struct FastMathTraits;
+	template<> struct FastMathTraits<float>
+	{
+		using bits = int32_t;
+		static constexpr int mantissaBits = 23;
+		static constexpr bits sqrtHalf = 0x3f3504f3;
+		static constexpr float belowOne = 0.99999994f;
+	};
+	template<> struct FastMathTraits<double>
+	{
+		using bits = int64_t;
+		static constexpr int mantissaBits = 52;
+		static constexpr bits sqrtHalf = 0x3fe6a09e667f3bcdLL;
+		static constexpr double belowOne = 0.99999999999999989;
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Branch free polynomial approximations of the waveshaper transcendentals.
+	The per-sample functions are inline and free of libm calls, so the block versions
+	auto-vectorize.
+*/
+/*===================================================================================*/
+	template<class T>
+	class FastMath
+	{
+	public:
+/*===================================================================================*/
+/*
+	[Function] atan(x): reduced to [0, 1] with atan(x) = pi/2 - atan(1/x), then a minimax
+	odd polynomial
+*/
+		template<Accuracy accuracy>
+		static AUXPORT_KERNEL T atan(T x)
+		{
+			T a = std::fabs(x);
+			T inverse = T(1) / a;
+			T t = a < inverse ? a : inverse;
+			T t2 = t * t;
+			T p;
+			if (accuracy == Accuracy::Low)
+				p = T(9.953578329e-01) + t2 * (T(-2.886895304e-01) + t2 * T(7.933830660e-02));
+			else if (accuracy == Accuracy::Medium)
+				p = T(9.998663264e-01) + t2 * (T(-3.303047285e-01) + t2 * (T(1.801590396e-01) + t2 * (T(-8.515594774e-02) + t2 * T(2.084490768e-02))));
+			else
+				p = T(9.999993355e-01) + t2 * (T(-3.332986045e-01) + t2 * (T(1.994656154e-01) + t2 * (T(-1.390860833e-01) + t2 * (T(9.642142171e-02) +
+					t2 * (T(-5.591156763e-02) + t2 * (T(2.186242985e-02) + t2 * T(-4.054421087e-03)))))));
+			T r = t * p;
+			r = a > T(1) ? T(halfPi) - r : r;
+			return std::copysign(r, x);
+		}
+/*===================================================================================*/
+/*
+	[Function] atanh(x) = 0.5 * ln((1 + x) / (1 - x)). The logarithm splits off the exponent
+	and evaluates ln(m) = 2 * atanh((m - 1) / (m + 1)) on m in [sqrt(0.5), sqrt(2)).
+	Unlike libm, |x| >= 1 is clamped just inside (-1, 1) so the result stays finite
+	(about +-8.7 for float, +-18.7 for double).
+*/
+		template<Accuracy accuracy>
+		static AUXPORT_KERNEL T atanh(T x)
+		{
+			using bits = typename FastMathTraits<T>::bits;
+			const T limit = FastMathTraits<T>::belowOne;
+			x = x > limit ? limit : x;
+			x = x < -limit ? -limit : x;
+			T z = (T(1) + x) / (T(1) - x);
+
+			bits zBits;
+			std::memcpy(&zBits, &z, sizeof(T));
+			bits offset = zBits - FastMathTraits<T>::sqrtHalf;
+			bits exponent = offset >> FastMathTraits<T>::mantissaBits;
+			bits mBits = zBits - (exponent << FastMathTraits<T>::mantissaBits);
+			T m;
+			std::memcpy(&m, &mBits, sizeof(T));
+
+			T s = (m - T(1)) / (m + T(1));
+			T s2 = s * s;
+			T q;
+			if (accuracy == Accuracy::Low)
+				q = T(9.999440225e-01) + s2 * T(3.408672059e-01);
+			else if (accuracy == Accuracy::Medium)
+				q = T(1.000000419e+00) + s2 * (T(3.332203879e-01) + s2 * T(2.075886128e-01));
+			else
+				q = T(9.999999969e-01) + s2 * (T(3.333347423e-01) + s2 * (T(1.998289707e-01) + s2 * T(1.505017271e-01)));
+			return T(halfLn2) * static_cast<T>(exponent) + s * q;
+		}
+/*===================================================================================*/
+/*
+	[Function] Block versions: buffer[i] = f(buffer[i]) over numSamples contiguous samples
+*/
+		static void atan(T* buffer, size_t numSamples, Accuracy accuracy = Accuracy::High)
+		{
+			switch (accuracy)
+			{
+			case Accuracy::Low: atanBlock<Accuracy::Low>(buffer, numSamples, T(1), T(1)); break;
+			case Accuracy::Medium: atanBlock<Accuracy::Medium>(buffer, numSamples, T(1), T(1)); break;
+			default: atanBlock<Accuracy::High>(buffer, numSamples, T(1), T(1)); break;
+			}
+		}
+
+		static void atanh(T* buffer, size_t numSamples, Accuracy accuracy = Accuracy::High)
+		{
+			switch (accuracy)
+			{
+			case Accuracy::Low: atanhBlock<Accuracy::Low>(buffer, numSamples, T(1), T(1)); break;
+			case Accuracy::Medium: atanhBlock<Accuracy::Medium>(buffer, numSamples, T(1), T(1)); break;
+			default: atanhBlock<Accuracy::High>(buffer, numSamples, T(1), T(1)); break;
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] buffer[i] = gain * f(scale * buffer[i]); the form every FX shaper reduces to
+*/
+		template<Accuracy accuracy>
+		static AUXPORT_KERNEL void atanBlock(T* buffer, size_t numSamples, T scale, T gain)
+		{
+			for (size_t i = 0; i < numSamples; i++)
+				buffer[i] = gain * atan<accuracy>(scale * buffer[i]);
+		}
+
+		template<Accuracy accuracy>
+		static AUXPORT_KERNEL void atanhBlock(T* buffer, size_t numSamples, T scale, T gain)
+		{
+			for (size_t i = 0; i < numSamples; i++)
+				buffer[i] = gain * atanh<accuracy>(scale * buffer[i]);
+		}
+
+		static constexpr double halfPi = 1.57079632679489661923;
+		static constexpr double halfLn2 = 0.34657359027997265471;
+	};
+}
+#endif
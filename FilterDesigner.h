@@ -0,0 +1,122 @@
+#pragma once
+#ifndef AuxPort_FilterDesigner_H
+#define AuxPort_FilterDesigner_H
+#include <cstdint>
+#include "BackgroundWorker.h"
+#include "LockFree.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Designs an Effect's filters on the BackgroundWorker thread (Kernel is the Effect type)
+
+	update() runs on the audio thread at every block boundary. It installs the newest
+	finished designs, then compares the keys the controls call for with the last ones it
+	asked for and, if they moved, hands the new request to the worker. Requests and results
+	travel through TripleBuffers, so neither side locks, allocates or waits, and a burst of
+	changes collapses to the newest one. A change is heard within one poll of the worker
+	(BackgroundWorker::pollIntervalMs) plus the design time, and applied at the next block.
+	The synchronous prepareToPlay() stays for reset(); call sync() after it. Every request
+	carries the generation it was made in and sync() starts a new one, so a design still in
+	flight across a reset is dropped even when the rate didn't change.
+*/
+/*===================================================================================*/
+	template<class Kernel>
+	class FilterDesigner : public BackgroundTask
+	{
+	public:
+		using Designs = typename Kernel::Designs;
+
+		explicit FilterDesigner(Kernel& kernel) : kernel(kernel) {}
+		~FilterDesigner()
+		{
+			stop();
+		}
+/*===================================================================================*/
+/*
+	[Function] Attaches to / detaches from the worker (not from the audio thread)
+*/
+		void start()
+		{
+			if (attached)
+				return;
+			BackgroundWorker::get().attach(this);
+			attached = true;
+		}
+
+		void stop()
+		{
+			if (!attached)
+				return;
+			BackgroundWorker::get().detach(this);
+			attached = false;
+		}
+/*===================================================================================*/
+/*
+	[Function] After a synchronous prepareToPlay(): the kernel's designs are current, so
+	forget what was asked for before; results still in flight belong to the previous
+	generation and update() drops them
+*/
+		void sync()
+		{
+			generation++;
+			kernel.describeDesigns(requested);
+		}
+/*===================================================================================*/
+/*
+	[Function] Audio thread, at a block boundary
+*/
+		void update()
+		{
+			if (results.update() && results.read().generation == generation)
+				kernel.applyDesigns(results.read().designs);
+			Job& job = requests.write();
+			Designs& request = job.designs;
+			job.generation = generation;
+			kernel.describeDesigns(request);
+			bool changed = false;
+			for (int i = 0; i < Kernel::numDesigns && !changed; i++)
+				changed = request.keys[i] != requested.keys[i];
+			if (!changed)
+				return;
+			for (int i = 0; i < Kernel::numDesigns; i++)
+				requested.keys[i] = request.keys[i];
+			if (!attached)
+			{
+				// no worker (offline use): design in place
+				Kernel::design(request);
+				kernel.applyDesigns(request);
+				return;
+			}
+			requests.publish();
+			requestService();
+		}
+/*===================================================================================*/
+/*
+	[Function] Worker thread: designs the newest request and publishes it
+*/
+		void service() override
+		{
+			if (!requests.update())
+				return;
+			Job& job = results.write();
+			job = requests.read();
+			Kernel::design(job.designs);
+			results.publish();
+		}
+	private:
+		struct Job
+		{
+			Designs designs;
+			uint32_t generation = 0;
+		};
+
+		Kernel& kernel;
+		TripleBuffer<Job> requests;
+		TripleBuffer<Job> results;
+		Designs requested;
+		uint32_t generation = 0;
+		bool attached = false;
+	};
+}
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+#ifndef AuxPort_Formats_H
+#define AuxPort_Formats_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Enum] Interleaved PCM sample formats (little endian; Int24 is packed 3 byte samples)
+*/
+/*===================================================================================*/
+	enum class SampleFormat
+	{
+		Int16, Int24, Float32
+	};
+
+	inline size_t bytesPerSample(SampleFormat format)
+	{
+		return format == SampleFormat::Int16 ? 2 : (format == SampleFormat::Int24 ? 3 : 4);
+	}
+
+/*===================================================================================*/
+/*
+	[Class] Interleaved <-> planar adapters
+
+	read() pulls one channel out of an interleaved buffer into a planar one, converting to T
+	and applying a gain in the same multiply as the integer scale (so an input gain stage
+	costs nothing); write() is the reverse, with rounding and clipping for the integer
+	formats. Each call is one strided loop with the format switch hoisted out of it. A
+	caller that reads all of a chunk's channels before writing the chunk back can use one
+	interleaved buffer for input and output when both have the same format. With
+	numChannels = 1 they convert a whole interleaved stream sample by sample.
+*/
+/*===================================================================================*/
+	template<class T>
+	class Interleaved
+	{
+	public:
+		static void read(const void* interleaved, SampleFormat format, size_t numChannels, size_t channel, size_t numFrames, T* planar, T gain = T(1))
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(interleaved);
+			switch (format)
+			{
+			case SampleFormat::Int16:
+			{
+				const T scale = gain * T(1.0 / 32768.0);
+				const size_t stride = numChannels * 2;
+				const uint8_t* s = bytes + channel * 2;
+				for (size_t i = 0; i < numFrames; i++, s += stride)
+				{
+					int16_t v = static_cast<int16_t>(static_cast<uint16_t>(s[0] | (s[1] << 8)));
+					planar[i] = static_cast<T>(v) * scale;
+				}
+				break;
+			}
+			case SampleFormat::Int24:
+			{
+				const T scale = gain * T(1.0 / 2147483648.0);
+				const size_t stride = numChannels * 3;
+				const uint8_t* s = bytes + channel * 3;
+				for (size_t i = 0; i < numFrames; i++, s += stride)
+				{
+					int32_t v = static_cast<int32_t>((static_cast<uint32_t>(s[0]) << 8) | (static_cast<uint32_t>(s[1]) << 16) | (static_cast<uint32_t>(s[2]) << 24));
+					planar[i] = static_cast<T>(v) * scale;
+				}
+				break;
+			}
+			case SampleFormat::Float32:
+			{
+				const size_t stride = numChannels * 4;
+				const uint8_t* s = bytes + channel * 4;
+				for (size_t i = 0; i < numFrames; i++, s += stride)
+				{
+					float v;
+					std::memcpy(&v, s, 4);
+					planar[i] = static_cast<T>(v) * gain;
+				}
+				break;
+			}
+			}
+		}
+
+		static void write(const T* planar, size_t numFrames, void* interleaved, SampleFormat format, size_t numChannels, size_t channel, T gain = T(1))
+		{
+			uint8_t* bytes = static_cast<uint8_t*>(interleaved);
+			switch (format)
+			{
+			case SampleFormat::Int16:
+			{
+				const size_t stride = numChannels * 2;
+				uint8_t* d = bytes + channel * 2;
+				for (size_t i = 0; i < numFrames; i++, d += stride)
+				{
+					int32_t v = quantize(planar[i] * gain, T(32768), 32767);
+					d[0] = static_cast<uint8_t>(v);
+					d[1] = static_cast<uint8_t>(v >> 8);
+				}
+				break;
+			}
+			case SampleFormat::Int24:
+			{
+				const size_t stride = numChannels * 3;
+				uint8_t* d = bytes + channel * 3;
+				for (size_t i = 0; i < numFrames; i++, d += stride)
+				{
+					int32_t v = quantize(planar[i] * gain, T(8388608), 8388607);
+					d[0] = static_cast<uint8_t>(v);
+					d[1] = static_cast<uint8_t>(v >> 8);
+					d[2] = static_cast<uint8_t>(v >> 16);
+				}
+				break;
+			}
+			case SampleFormat::Float32:
+			{
+				const size_t stride = numChannels * 4;
+				uint8_t* d = bytes + channel * 4;
+				for (size_t i = 0; i < numFrames; i++, d += stride)
+				{
+					float v = static_cast<float>(planar[i] * gain);
+					std::memcpy(d, &v, 4);
+				}
+				break;
+			}
+			}
+		}
+	private:
+		static int32_t quantize(T x, T scale, int32_t top)
+		{
+			T y = x * scale;
+			y = y < T(-top - 1) ? T(-top - 1) : (y > T(top) ? T(top) : y);
+			return static_cast<int32_t>(y < T(0) ? y - T(0.5) : y + T(0.5));
+		}
+	};
+}
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+#ifndef AuxPort_Governor_H
+#define AuxPort_Governor_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Enum] Processing tiers, most to least expensive (see Effect::setTier)
+*/
+/*===================================================================================*/
+	enum class Tier
+	{
+		Full, Reduced, Minimal
+	};
+
+	constexpr int numTiers = 3;
+
+	inline const char* toString(Tier tier)
+	{
+		return tier == Tier::Full ? "Full" : (tier == Tier::Reduced ? "Reduced" : "Minimal");
+	}
+
+/*===================================================================================*/
+/*
+	[Class] Load governor
+
+	Fed each callback's load (processing time / real-time budget, as returned by
+	CallbackTelemetry::end()) and keeps a smoothed load. A callback over budget, or a
+	smoothed load above stepDownLoad after holdCallbacks callbacks at the current tier,
+	drops one tier; recoverCallbacks callbacks in a row below stepUpLoad climb back one.
+	update() runs on the audio thread and never blocks; the metrics are atomics any
+	thread may read.
+*/
+/*===================================================================================*/
+	class LoadGovernor
+	{
+	public:
+		struct Settings
+		{
+			double stepDownLoad = 0.8;
+			double stepUpLoad = 0.5;
+			double smoothing = 0.1;
+			uint32_t holdCallbacks = 32;
+			uint32_t recoverCallbacks = 512;
+			Tier lowest = Tier::Minimal;
+		};
+
+		struct Metrics
+		{
+			std::atomic<double> load{ 0.0 };
+			std::atomic<double> peakLoad{ 0.0 };
+			std::atomic<int> tier{ 0 };
+			std::atomic<uint64_t> callbacks{ 0 };
+			std::atomic<uint64_t> overruns{ 0 };
+			std::atomic<uint64_t> stepDowns{ 0 };
+			std::atomic<uint64_t> stepUps{ 0 };
+		};
+
+		LoadGovernor() = default;
+		explicit LoadGovernor(const Settings& settings) : settings(settings) {}
+		LoadGovernor(const LoadGovernor&) = delete;
+		LoadGovernor& operator=(const LoadGovernor&) = delete;
+
+		void setEnabled(bool state)
+		{
+			enabled = state;
+		}
+/*===================================================================================*/
+/*
+	[Function] Feeds one callback's load; true if the tier changed (read it with getTier())
+*/
+		bool update(double load)
+		{
+			smoothed += settings.smoothing * (load - smoothed);
+			metrics.load.store(smoothed, std::memory_order_relaxed);
+			if (load > metrics.peakLoad.load(std::memory_order_relaxed))
+				metrics.peakLoad.store(load, std::memory_order_relaxed);
+			metrics.callbacks.fetch_add(1, std::memory_order_relaxed);
+			const bool overrun = load > 1.0;
+			if (overrun)
+				metrics.overruns.fetch_add(1, std::memory_order_relaxed);
+			if (!enabled)
+				return false;
+
+			held++;
+			calm = smoothed < settings.stepUpLoad ? calm + 1 : 0;
+			if (tier < static_cast<int>(settings.lowest) && (overrun || (smoothed > settings.stepDownLoad && held >= settings.holdCallbacks)))
+			{
+				setTier(tier + 1);
+				metrics.stepDowns.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+			if (tier > 0 && calm >= settings.recoverCallbacks)
+			{
+				setTier(tier - 1);
+				metrics.stepUps.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+			return false;
+		}
+
+		Tier getTier() const
+		{
+			return static_cast<Tier>(tier);
+		}
+
+		const Metrics& getMetrics() const
+		{
+			return metrics;
+		}
+/*===================================================================================*/
+/*
+	[Function] Back to the Full tier with fresh statistics (counters are kept)
+*/
+		void reset()
+		{
+			smoothed = 0.0;
+			held = 0;
+			calm = 0;
+			tier = 0;
+			metrics.tier.store(0, std::memory_order_relaxed);
+			metrics.load.store(0.0, std::memory_order_relaxed);
+			metrics.peakLoad.store(0.0, std::memory_order_relaxed);
+		}
+	private:
+		void setTier(int newTier)
+		{
+			tier = newTier;
+			held = 0;
+			calm = 0;
+			metrics.tier.store(newTier, std::memory_order_relaxed);
+		}
+
+		Settings settings;
+		Metrics metrics;
+		double smoothed = 0.0;
+		uint32_t held = 0;
+		uint32_t calm = 0;
+		int tier = 0;
+		bool enabled = true;
+	};
+}
+#endif
@@ -0,0 +1,490 @@
+#pragma once
+#ifndef AuxPort_Graph_H
+#define AuxPort_Graph_H
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "fxobjects.h"
+#include "FX.h"
+#include "Waveshaper.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Declarative DSP graph
+
+	Describe a signal flow as nodes (Filter, FullWave, FX shapers, weighted mixes) whose
+	inputs are other nodes or the two graph inputs, then compile() it once at prepare time:
+	- the nodes are topologically sorted into a flat schedule (cycles and dangling inputs
+	  make compile() return false); nodes that don't reach the output are dropped
+	- a liveness pass gives every intermediate a slot in one preallocated arena, reusing a
+	  slot as soon as its last reader has run and running a node in place on its input's
+	  slot when it is that input's last reader
+	so process() is a straight walk over the schedule with no allocation and no lookups.
+
+	Parameters are Values: a constant times up to three controls (read through the Reader
+	passed to update(), e.g. Effect's getControl), so gains like masterD * A1 can be bound
+	directly. Effect::load() swaps a compiled graph in for the built-in signal flow.
+
+	compile() also gives every arctan shaper a TableShaper, kept at the shaper's alpha by
+	update(); below Accuracy::High the shaper reads that table instead of the polynomial.
+	Copies share the tables until they are compiled themselves.
+*/
+/*===================================================================================*/
+	template<class bufferType, class effectType>
+	class Graph
+	{
+	public:
+		using NodeID = int;
+		static constexpr NodeID inputLeft = 0;
+		static constexpr NodeID inputRight = 1;
+
+		enum class Shape
+		{
+			Gain, DCOffset, ZeroCrossing, ArcTan1, ArcTan2, ArcTanH, Fullwave, Halfwave
+		};
+
+		struct Value
+		{
+			Value(effectType constant = effectType(1)) : scale(constant) {}
+			effectType scale;
+			int controls[3] = { -1, -1, -1 };
+			Value operator*(const Value& other) const
+			{
+				Value product(scale * other.scale);
+				int n = 0;
+				for (const Value* v : { this, &other })
+				{
+					for (int control : v->controls)
+					{
+						if (control >= 0 && n < 3)
+							product.controls[n++] = control;
+					}
+				}
+				return product;
+			}
+		};
+
+		static Value control(int controlID)
+		{
+			Value value;
+			value.controls[0] = controlID;
+			return value;
+		}
+
+		Graph()
+		{
+			nodes.resize(2);
+			nodes[inputLeft].type = Type::Input;
+			nodes[inputRight].type = Type::Input;
+		}
+		Graph(const Graph&) = default;
+		~Graph() = default;
+/*===================================================================================*/
+/*
+	[Functions] Declaring nodes. Inputs may name nodes declared later; compile() checks them.
+*/
+		NodeID addFilter(NodeID input, filterAlgorithm algorithm, Value fc, Value Q, Value boost = Value(0))
+		{
+			Node node;
+			node.type = Type::Filter;
+			node.algorithm = algorithm;
+			node.inputs.push_back({ input, Value() });
+			node.parameters[0] = fc;
+			node.parameters[1] = Q;
+			node.parameters[2] = boost;
+			return add(node);
+		}
+
+		NodeID addFullWave(NodeID input, Value enabled = Value(1))
+		{
+			Node node;
+			node.type = Type::FullWave;
+			node.inputs.push_back({ input, Value() });
+			node.parameters[0] = enabled;
+			return add(node);
+		}
+
+		NodeID addShaper(NodeID input, Shape shape, Value alpha = Value(1), Value mix = Value(1))
+		{
+			Node node;
+			node.type = Type::Shaper;
+			node.shape = shape;
+			node.inputs.push_back({ input, Value() });
+			node.parameters[0] = alpha;
+			node.parameters[1] = mix;
+			return add(node);
+		}
+
+		NodeID addMix(std::initializer_list<std::pair<NodeID, Value>> inputs)
+		{
+			Node node;
+			node.type = Type::Mix;
+			for (const auto& input : inputs)
+				node.inputs.push_back({ input.first, input.second });
+			return add(node);
+		}
+
+		void setOutput(NodeID node)
+		{
+			output = node;
+			compiled = false;
+		}
+/*===================================================================================*/
+/*
+	[Function] Sorts, prunes and allocates; returns false if the graph is not a DAG reaching
+	the output. Not for the audio thread.
+*/
+		bool compile(double sampleRate, size_t maxBlockSize)
+		{
+			compiled = false;
+			const int count = static_cast<int>(nodes.size());
+			if (output < 0 || output >= count || maxBlockSize == 0)
+				return false;
+			for (const Node& node : nodes)
+			{
+				for (const Input& input : node.inputs)
+				{
+					if (input.node < 0 || input.node >= count)
+						return false;
+				}
+			}
+
+			std::vector<char> needed(count, 0);
+			std::vector<NodeID> stack{ output };
+			while (!stack.empty())
+			{
+				NodeID id = stack.back();
+				stack.pop_back();
+				if (needed[id])
+					continue;
+				needed[id] = 1;
+				for (const Input& input : nodes[id].inputs)
+					stack.push_back(input.node);
+			}
+
+			std::vector<int> pending(count, 0);
+			std::vector<std::vector<NodeID>> readers(count);
+			for (NodeID id = 0; id < count; id++)
+			{
+				if (!needed[id])
+					continue;
+				for (const Input& input : nodes[id].inputs)
+				{
+					pending[id]++;
+					readers[input.node].push_back(id);
+				}
+			}
+			std::vector<NodeID> order;
+			std::vector<NodeID> ready;
+			for (NodeID id = 0; id < count; id++)
+			{
+				if (needed[id] && pending[id] == 0)
+					ready.push_back(id);
+			}
+			while (!ready.empty())
+			{
+				NodeID id = ready.back();
+				ready.pop_back();
+				order.push_back(id);
+				for (NodeID reader : readers[id])
+				{
+					if (--pending[reader] == 0)
+						ready.push_back(reader);
+				}
+			}
+			size_t neededCount = 0;
+			for (char n : needed)
+				neededCount += n;
+			if (order.size() != neededCount)
+				return false;
+
+			std::vector<int> usesLeft(count, 0);
+			for (NodeID id : order)
+			{
+				for (const Input& input : nodes[id].inputs)
+					usesLeft[input.node]++;
+			}
+			usesLeft[output]++;
+
+			schedule.clear();
+			std::vector<int> freeSlots;
+			int slotCount = 0;
+			for (NodeID id : order)
+			{
+				Node& node = nodes[id];
+				if (node.type == Type::Input)
+				{
+					node.slot = -1 - id;
+					continue;
+				}
+				const Input& first = node.inputs.front();
+				bool firstOnce = true;
+				for (size_t k = 1; k < node.inputs.size(); k++)
+					firstOnce = firstOnce && node.inputs[k].node != first.node;
+				if (nodes[first.node].type != Type::Input && usesLeft[first.node] == 1 && firstOnce)
+					node.slot = nodes[first.node].slot;
+				else if (!freeSlots.empty())
+				{
+					node.slot = freeSlots.back();
+					freeSlots.pop_back();
+				}
+				else
+					node.slot = slotCount++;
+				for (const Input& input : node.inputs)
+				{
+					if (--usesLeft[input.node] == 0 && nodes[input.node].type != Type::Input && nodes[input.node].slot != node.slot)
+						freeSlots.push_back(nodes[input.node].slot);
+				}
+				node.filter.reset(sampleRate);
+				node.fullWave.reset();
+				node.table.reset();
+				if (node.type == Type::Shaper && (node.shape == Shape::ArcTan1 || node.shape == Shape::ArcTan2 || node.shape == Shape::ArcTanH))
+				{
+					const Curve curve = node.shape == Shape::ArcTan1 ? Curve::ArcTan1 : (node.shape == Shape::ArcTan2 ? Curve::ArcTan2 : Curve::ArcTanH);
+					node.table = std::make_shared<TableShaper<bufferType>>(curve, static_cast<bufferType>(node.parameters[0].scale), tableSize, tableRange);
+				}
+				schedule.push_back(id);
+			}
+
+			blockSize = maxBlockSize;
+			arena.assign(static_cast<size_t>(slotCount) * blockSize, bufferType(0));
+			slots = slotCount;
+			compiled = true;
+			return true;
+		}
+/*===================================================================================*/
+/*
+	[Function] Clears node state and redesigns the filters for a new sample rate
+*/
+		void reset(double sampleRate)
+		{
+			for (Node& node : nodes)
+			{
+				node.filter.reset(sampleRate);
+				node.fullWave.reset();
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Resolves every Value through read(controlID) (block rate, audio thread safe)
+*/
+		template<class Reader>
+		void update(Reader&& read)
+		{
+			for (NodeID id : schedule)
+			{
+				Node& node = nodes[id];
+				for (int i = 0; i < 3; i++)
+					node.resolved[i] = static_cast<bufferType>(resolve(node.parameters[i], read));
+				for (Input& input : node.inputs)
+					input.resolved = static_cast<bufferType>(resolve(input.weight, read));
+				if (node.table)
+					node.table->setAlpha(node.resolved[0]);
+				if (node.type == Type::Filter)
+				{
+					node.filter.setFilterType(node.algorithm);
+					node.filter.setParameters(static_cast<effectType>(resolve(node.parameters[0], read)),
+						static_cast<effectType>(resolve(node.parameters[1], read)),
+						static_cast<effectType>(resolve(node.parameters[2], read)));
+				}
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Runs the schedule; output may alias either input. Right may be nullptr (mono).
+*/
+		void process(const bufferType* left, const bufferType* right, bufferType* out, size_t numSamples)
+		{
+			if (!compiled)
+				return;
+			right = right ? right : left;
+			for (size_t start = 0; start < numSamples; start += blockSize)
+			{
+				const size_t count = numSamples - start < blockSize ? numSamples - start : blockSize;
+				inputs[0] = left + start;
+				inputs[1] = right + start;
+				for (NodeID id : schedule)
+					run(nodes[id], count);
+				const bufferType* result = buffer(nodes[output].slot);
+				if (result != out + start)
+					std::memmove(out + start, result, count * sizeof(bufferType));
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Arena slots the compiled schedule needs (each maxBlockSize samples)
+*/
+		int slotCount() const
+		{
+			return slots;
+		}
+
+		bool isCompiled() const
+		{
+			return compiled;
+		}
+/*===================================================================================*/
+/*
+	[Function] Approximation the arctan shapers use: High (the default) runs FastMath's
+	polynomial, anything lower their lookup tables, which is what the load governor's
+	cheaper tiers ask for
+*/
+		void setAccuracy(Accuracy newAccuracy)
+		{
+			accuracy = newAccuracy;
+		}
+/*===================================================================================*/
+/*
+	[Function] Effect's built-in signal flow, as a graph
+*/
+		static Graph effectFlow()
+		{
+			Graph graph;
+			Value preGain = control(controlID::preGain);
+			Value dryWeight = control(controlID::masterC);
+			Value rightWeight = control(controlID::masterD) * control(controlID::A1);
+			Value leftWeight = control(controlID::masterD) * control(controlID::A2);
+
+			NodeID gainLeft = graph.addMix({ { inputLeft, preGain } });
+			NodeID gainRight = graph.addMix({ { inputRight, preGain } });
+			NodeID lowPassLeft = graph.addFilter(gainLeft, filterAlgorithm::kButterLPF2, control(controlID::lowPassFC), control(controlID::lowPass_Q), control(controlID::lpfBoost));
+			NodeID lowPassRight = graph.addFilter(gainRight, filterAlgorithm::kButterLPF2, control(controlID::lowPassFC), control(controlID::lowPass_Q), control(controlID::lpfBoost));
+			NodeID mono = graph.addMix({ { lowPassLeft, Value() }, { lowPassRight, Value() } });
+			NodeID rectified = graph.addFullWave(mono, control(controlID::fullWaveSwitch));
+			NodeID bandPass = graph.addFilter(rectified, filterAlgorithm::kBPF2, control(controlID::bandPassFC), control(controlID::bandPassQ), control(controlID::bandPassBoost));
+			NodeID highPassLeft = graph.addFilter(gainLeft, filterAlgorithm::kButterHPF2, control(controlID::highPassFC), control(controlID::highPassQ), control(controlID::hpfBoost));
+			NodeID highPassRight = graph.addFilter(gainRight, filterAlgorithm::kButterHPF2, control(controlID::highPassFC), control(controlID::highPassQ), control(controlID::hpfBoost));
+			NodeID dry = graph.addMix({ { inputLeft, Value() }, { inputRight, Value() } });
+			graph.setOutput(graph.addMix({
+				{ highPassRight, rightWeight }, { bandPass, rightWeight },
+				{ bandPass, leftWeight }, { highPassLeft, leftWeight },
+				{ dry, dryWeight } }));
+			return graph;
+		}
+	private:
+		enum class Type
+		{
+			Input, Filter, FullWave, Shaper, Mix
+		};
+
+		struct Input
+		{
+			NodeID node;
+			Value weight;
+			bufferType resolved = 1;
+		};
+
+		struct Node
+		{
+			Type type = Type::Mix;
+			filterAlgorithm algorithm = filterAlgorithm::kLPF2;
+			Shape shape = Shape::Gain;
+			std::vector<Input> inputs;
+			Value parameters[3];
+			bufferType resolved[3] = { 1, 1, 1 };
+			int slot = 0;
+			Filter<bufferType, effectType> filter;
+			FullWave<bufferType> fullWave;
+			std::shared_ptr<TableShaper<bufferType>> table;		// arctan shapers, below Accuracy::High
+		};
+
+		static constexpr size_t tableSize = 4096;
+		static constexpr bufferType tableRange = 16;		// of alpha * x; about 3e-5 from the curve
+
+		NodeID add(const Node& node)
+		{
+			nodes.push_back(node);
+			compiled = false;
+			return static_cast<NodeID>(nodes.size() - 1);
+		}
+
+		template<class Reader>
+		static effectType resolve(const Value& value, Reader& read)
+		{
+			effectType result = value.scale;
+			for (int control : value.controls)
+			{
+				if (control >= 0)
+					result *= static_cast<effectType>(read(control));
+			}
+			return result;
+		}
+
+		bufferType* buffer(int slot)
+		{
+			return slot < 0 ? const_cast<bufferType*>(inputs[-1 - slot]) : arena.data() + static_cast<size_t>(slot) * blockSize;
+		}
+
+		void run(Node& node, size_t count)
+		{
+			bufferType* out = buffer(node.slot);
+			const bufferType* in = buffer(nodes[node.inputs.front().node].slot);
+			switch (node.type)
+			{
+			case Type::Filter:
+				node.filter.process(in, out, count);
+				break;
+			case Type::FullWave:
+				if (in != out)
+					std::memcpy(out, in, count * sizeof(bufferType));
+				node.fullWave.process(out, count, node.resolved[0] != bufferType(0));
+				break;
+			case Type::Shaper:
+				shape(node, in, out, count);
+				break;
+			case Type::Mix:
+			{
+				const bufferType weight = node.inputs.front().resolved;
+				for (size_t i = 0; i < count; i++)
+					out[i] = weight * in[i];
+				for (size_t k = 1; k < node.inputs.size(); k++)
+				{
+					const bufferType* other = buffer(nodes[node.inputs[k].node].slot);
+					const bufferType w = node.inputs[k].resolved;
+					for (size_t i = 0; i < count; i++)
+						out[i] += w * other[i];
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		void shape(const Node& node, const bufferType* in, bufferType* out, size_t count) const
+		{
+			const bufferType alpha = node.resolved[0];
+			const bufferType mix = node.resolved[1];
+			if (node.table && accuracy != Accuracy::High)
+			{
+				node.table->process(in, out, count, mix);
+				return;
+			}
+			switch (node.shape)
+			{
+			case Shape::Gain: FX<bufferType>::PreGain(in, out, count, alpha * mix); break;
+			case Shape::DCOffset: FX<bufferType>::template DCOffset<true>(in, out, count, alpha, mix); break;
+			case Shape::ZeroCrossing: FX<bufferType>::template ZeroCrossing<true>(in, out, count, alpha, mix); break;
+			case Shape::ArcTan1: FX<bufferType>::template ArcTan1<true>(in, out, count, alpha, mix, accuracy); break;
+			case Shape::ArcTan2: FX<bufferType>::template ArcTan2<true>(in, out, count, alpha, mix, accuracy); break;
+			case Shape::ArcTanH: FX<bufferType>::template ArcTanH<true>(in, out, count, alpha, mix, accuracy); break;
+			case Shape::Fullwave: FX<bufferType>::template Fullwave<true>(in, out, count); break;
+			case Shape::Halfwave: FX<bufferType>::template Halfwave<true>(in, out, count); break;
+			}
+		}
+
+		std::vector<Node> nodes;
+		std::vector<NodeID> schedule;
+		std::vector<bufferType> arena;
+		const bufferType* inputs[2] = { nullptr, nullptr };
+		NodeID output = -1;
+		size_t blockSize = 0;
+		int slots = 0;
+		bool compiled = false;
+		Accuracy accuracy = Accuracy::High;
+	};
+}
+#endif
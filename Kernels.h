@@ -0,0 +1,176 @@
+#pragma once
+#ifndef AuxPort_Kernels_H
+#define AuxPort_Kernels_H
+#include <cstddef>
+#include "FastMath.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Namespace] The inner loops of the Filter, Crossover and FullWave block paths (the FX
+	shapers' loops are FastMath's atanBlock/atanhBlock). They are always-inline templates so
+	Dispatch.h can compile each one once per instruction set and pick the right copy at
+	runtime.
+*/
+/*===================================================================================*/
+	namespace Kernel
+	{
+/*===================================================================================*/
+/*
+	[Function] Transposed direct form II biquad; coefficients are a0, a1, a2, b1, b2
+*/
+		template<class T>
+		AUXPORT_KERNEL void biquad(const T* input, T* output, size_t numSamples, const T* coefficients, T& z1, T& z2)
+		{
+			const T a0 = coefficients[0], a1 = coefficients[1], a2 = coefficients[2], b1 = coefficients[3], b2 = coefficients[4];
+			T s1 = z1, s2 = z2;
+			for (size_t i = 0; i < numSamples; i++)
+			{
+				T x = input[i];
+				T y = a0 * x + s1;
+				s1 = a1 * x - b1 * y + s2;
+				s2 = a2 * x - b2 * y;
+				output[i] = y;
+			}
+			z1 = (s1 < T(1e-30) && s1 > T(-1e-30)) ? T(0) : s1;
+			z2 = (s2 < T(1e-30) && s2 > T(-1e-30)) ? T(0) : s2;
+		}
+/*===================================================================================*/
+/*
+	[Function] FullWave's zero crossing integrator, in place, as a segmented scan
+
+	The recurrence y[n] = reset[n] ? 0 : y[n-1] + x[n-1], reset[n] = x[n] > 0 && x[n-1] <= 0
+	splits into two passes per chunk:
+	- the reset mask only depends on the input, so that pass (and counting the resets) has
+	  no loop carried dependency and vectorizes
+	- the carry pass is the segmented prefix sum itself: a plain add chain when the chunk
+	  has no reset (the common case after the low pass), otherwise one add and one select
+	  per sample with no data dependent branch to mispredict
+	A log-step (Hillis-Steele / Blelloch) tree would evaluate the sums in a different
+	order; floating point addition is not associative, so it could not match the scalar
+	FullWave::process sample for sample. The carry pass therefore stays serial.
+*/
+		template<class T>
+		AUXPORT_KERNEL void fullWave(T* buffer, size_t numSamples, T& previousFrame, T& previousProcessedFrame)
+		{
+			constexpr size_t chunk = 64;
+			unsigned char reset[chunk];
+			T previous = previousFrame;
+			T accumulated = previousProcessedFrame;
+			for (size_t start = 0; start < numSamples; start += chunk)
+			{
+				T* x = buffer + start;
+				const size_t count = numSamples - start < chunk ? numSamples - start : chunk;
+				reset[0] = (x[0] > T(0)) & (previous <= T(0));
+				unsigned resets = reset[0];
+				for (size_t i = 1; i < count; i++)
+				{
+					reset[i] = (x[i] > T(0)) & (x[i - 1] <= T(0));
+					resets += reset[i];
+				}
+				if (resets == 0)
+				{
+					for (size_t i = 0; i < count; i++)
+					{
+						accumulated += previous;
+						previous = x[i];
+						x[i] = accumulated;
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < count; i++)
+					{
+						T sum = accumulated + previous;
+						previous = x[i];
+						accumulated = reset[i] ? T(0) : sum;
+						x[i] = accumulated;
+					}
+				}
+			}
+			previousFrame = previous;
+			previousProcessedFrame = accumulated;
+		}
+/*===================================================================================*/
+/*
+	[Function] Stereo Linkwitz-Riley crossover from trapezoidal state variable filters, both
+	channels side by side in the lanes of one loop
+
+	coefficients are a1, a2, a3, k of the SVF (Crossover::design); state is ic1, ic2 per
+	channel for each stage (8 values). Both bands come out of the one structure:
+	- order 2: one SVF at Q = 0.5; low = LP, high = -HP, so low + high is a first order allpass
+	- order 4: a Butterworth SVF gives LP1 and the allpass AP = x - 2k BP1; a second one on
+	  LP1 gives low = LP1^2, and high = AP - low, which is exactly HP1^2. low + high is the
+	  second order allpass, so the bands recombine flat in magnitude.
+	The inputs are scaled by gain on the way in.
+*/
+		template<class T>
+		AUXPORT_KERNEL void crossover(const T* left, const T* right, T* lowLeft, T* lowRight, T* highLeft, T* highRight, size_t numSamples,
+			const T* coefficients, T* state, int order, T gain)
+		{
+			const T a1 = coefficients[0], a2 = coefficients[1], a3 = coefficients[2], k = coefficients[3];
+			T ic1[2] = { state[0], state[1] }, ic2[2] = { state[2], state[3] };
+			if (order == 2)
+			{
+				for (size_t i = 0; i < numSamples; i++)
+				{
+					const T x[2] = { gain * left[i], gain * right[i] };
+					T low[2], high[2];
+					for (int c = 0; c < 2; c++)
+					{
+						const T v3 = x[c] - ic2[c];
+						const T v1 = a1 * ic1[c] + a2 * v3;
+						const T v2 = ic2[c] + a2 * ic1[c] + a3 * v3;
+						ic1[c] = T(2) * v1 - ic1[c];
+						ic2[c] = T(2) * v2 - ic2[c];
+						low[c] = v2;
+						high[c] = k * v1 + v2 - x[c];
+					}
+					lowLeft[i] = low[0];
+					lowRight[i] = low[1];
+					highLeft[i] = high[0];
+					highRight[i] = high[1];
+				}
+			}
+			else
+			{
+				T jc1[2] = { state[4], state[5] }, jc2[2] = { state[6], state[7] };
+				for (size_t i = 0; i < numSamples; i++)
+				{
+					const T x[2] = { gain * left[i], gain * right[i] };
+					T low[2], high[2];
+					for (int c = 0; c < 2; c++)
+					{
+						const T v3 = x[c] - ic2[c];
+						const T v1 = a1 * ic1[c] + a2 * v3;
+						const T v2 = ic2[c] + a2 * ic1[c] + a3 * v3;
+						ic1[c] = T(2) * v1 - ic1[c];
+						ic2[c] = T(2) * v2 - ic2[c];
+						const T w3 = v2 - jc2[c];
+						const T w1 = a1 * jc1[c] + a2 * w3;
+						const T w2 = jc2[c] + a2 * jc1[c] + a3 * w3;
+						jc1[c] = T(2) * w1 - jc1[c];
+						jc2[c] = T(2) * w2 - jc2[c];
+						low[c] = w2;
+						high[c] = x[c] - T(2) * k * v1 - w2;
+					}
+					lowLeft[i] = low[0];
+					lowRight[i] = low[1];
+					highLeft[i] = high[0];
+					highRight[i] = high[1];
+				}
+				for (int c = 0; c < 2; c++)
+				{
+					state[4 + c] = (jc1[c] < T(1e-30) && jc1[c] > T(-1e-30)) ? T(0) : jc1[c];
+					state[6 + c] = (jc2[c] < T(1e-30) && jc2[c] > T(-1e-30)) ? T(0) : jc2[c];
+				}
+			}
+			for (int c = 0; c < 2; c++)
+			{
+				state[c] = (ic1[c] < T(1e-30) && ic1[c] > T(-1e-30)) ? T(0) : ic1[c];
+				state[2 + c] = (ic2[c] < T(1e-30) && ic2[c] > T(-1e-30)) ? T(0) : ic2[c];
+			}
+		}
+	}
+}
+#endif
@@ -0,0 +1,317 @@
+#pragma once
+#ifndef AuxPort_Limiter_H
+#define AuxPort_Limiter_H
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Snapshot.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Lookahead peak limiter for the Effect's (mono) output
+
+	The signal is delayed by lookahead samples. Per sample, the peak over the last
+	lookahead + 1 inputs comes from a monotonic deque (O(1) amortized), and the gain that
+	peak calls for is held (falling at once, recovering with the release time). The gain
+	actually applied is the mean of the held gain over the last lookahead samples. A peak
+	is in the window for the whole lookahead before it leaves the delay, so every term of
+	that mean is at most its gain when it comes out: the output never exceeds the ceiling,
+	and gain reduction ramps in linearly over the lookahead instead of clicking.
+
+	The deque and the release are the only serial steps; turning peaks into gains and
+	applying the gain are plain loops over a chunk that vectorize. While disabled the stage
+	is a pure delay, so the latency stays put when it is switched; it starts from unity
+	gain when switched back on.
+*/
+/*===================================================================================*/
+	template<class bufferType>
+	class Limiter
+	{
+	public:
+		static constexpr double maxLookaheadMs = 20.0;
+
+		Limiter() = default;
+/*===================================================================================*/
+/*
+	[Function] Lookahead in milliseconds (0 = no limiter and no latency); takes effect at the
+	next prepare()
+*/
+		void setLookahead(double ms)
+		{
+			lookaheadMs = ms > 0.0 ? std::min(ms, maxLookaheadMs) : 0.0;
+		}
+
+		double getLookahead() const
+		{
+			return lookaheadMs;
+		}
+/*===================================================================================*/
+/*
+	[Function] Sizes the delay for sampleRate and clears everything (allocates; from reset(),
+	not from the audio thread)
+*/
+		void prepare(double newSampleRate)
+		{
+			sampleRate = newSampleRate;
+			lookahead = lookaheadMs > 0.0 ? std::max<size_t>(1, static_cast<size_t>(std::llround(lookaheadMs * 0.001 * sampleRate))) : 0;
+			delay.assign(lookahead, bufferType(0));
+			held.assign(lookahead, bufferType(1));
+			peakValue.assign(lookahead + 1, bufferType(0));
+			peakIndex.assign(lookahead + 1, 0);
+			releaseMs = -1.0;
+			setRelease(100.0);
+			clear();
+		}
+
+		bool isActive() const
+		{
+			return lookahead > 0;
+		}
+
+		size_t getLatencySamples() const
+		{
+			return lookahead;
+		}
+/*===================================================================================*/
+/*
+	[Function] Controls, cheap to call every block: nothing is recomputed unless a value moved
+*/
+		void setEnabled(bool on)
+		{
+			if (on && !enabled)
+				restartGain();
+			enabled = on;
+		}
+
+		void setCeiling(double dB)
+		{
+			if (dB == ceilingDb)
+				return;
+			ceilingDb = dB;
+			ceiling = static_cast<bufferType>(std::pow(10.0, dB / 20.0));
+		}
+
+		void setRelease(double ms)
+		{
+			if (ms == releaseMs)
+				return;
+			releaseMs = ms;
+			releaseCoefficient = static_cast<bufferType>(1.0 - std::exp(-1.0 / (std::max(ms, 0.1) * 0.001 * sampleRate)));
+		}
+/*===================================================================================*/
+/*
+	[Function] Limits numSamples in place (delayed by getLatencySamples())
+*/
+		void process(bufferType* buffer, size_t numSamples)
+		{
+			if (lookahead == 0)
+				return;
+			for (size_t start = 0; start < numSamples; start += chunk)
+			{
+				const size_t count = numSamples - start < chunk ? numSamples - start : chunk;
+				bufferType* x = buffer + start;
+				if (!enabled)
+				{
+					delayLine(x, count);
+					continue;
+				}
+				bufferType gain[chunk];
+				slidingPeaks(x, gain, count);
+				// the gain each peak calls for: ceiling / max(peak, ceiling), branch free
+				for (size_t i = 0; i < count; i++)
+					gain[i] = ceiling / (gain[i] > ceiling ? gain[i] : ceiling);
+				smooth(gain, count);
+				delayLine(x, count);
+				for (size_t i = 0; i < count; i++)
+					x[i] *= gain[i];
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Gain applied to the last sample (1 = no reduction), for metering
+*/
+		bufferType getGain() const
+		{
+			return static_cast<bufferType>(heldSum / static_cast<double>(lookahead ? lookahead : 1));
+		}
+
+		void clear()
+		{
+			std::fill(delay.begin(), delay.end(), bufferType(0));
+			position = 0;
+			counter = 0;
+			peakHead = 0;
+			peakCount = 0;
+			restartGain();
+		}
+
+		void save(StateWriter& writer) const
+		{
+			writer.write(static_cast<uint32_t>(lookahead));
+			writer.write(enabled);
+			writer.write(static_cast<uint32_t>(position));
+			writer.write(counter);
+			writer.write(static_cast<uint32_t>(peakHead));
+			writer.write(static_cast<uint32_t>(peakCount));
+			writer.write(release);
+			writer.write(heldSum);
+			writer.write(delay.data(), delay.size());
+			writer.write(held.data(), held.size());
+			writer.write(peakValue.data(), peakValue.size());
+			writer.write(peakIndex.data(), peakIndex.size());
+		}
+
+		bool restore(StateReader& reader)
+		{
+			uint32_t savedLookahead = 0, savedPosition = 0, savedHead = 0, savedCount = 0;
+			if (!reader.read(savedLookahead) || savedLookahead != lookahead)
+				return false;
+			reader.read(enabled);
+			reader.read(savedPosition);
+			reader.read(counter);
+			reader.read(savedHead);
+			reader.read(savedCount);
+			if (!reader.good() || (lookahead > 0 && (savedPosition >= lookahead || savedHead > lookahead || savedCount > lookahead + 1)))
+				return false;
+			position = savedPosition;
+			peakHead = savedHead;
+			peakCount = savedCount;
+			reader.read(release);
+			reader.read(heldSum);
+			reader.read(delay.data(), delay.size());
+			reader.read(held.data(), held.size());
+			reader.read(peakValue.data(), peakValue.size());
+			reader.read(peakIndex.data(), peakIndex.size());
+			return reader.good();
+		}
+	private:
+		static constexpr size_t chunk = 256;
+
+/*===================================================================================*/
+/*
+	[Function] Swaps x through the delay ring, a contiguous run of it at a time
+*/
+		void delayLine(bufferType* x, size_t count)
+		{
+			for (size_t done = 0; done < count;)
+			{
+				const size_t run = std::min(count - done, lookahead - position);
+				std::swap_ranges(x + done, x + done + run, delay.data() + position);
+				done += run;
+				position += run;
+				if (position == lookahead)
+					position = 0;
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Peak of |x| over the last lookahead + 1 samples, for each sample: the deque
+	keeps the window's decreasing maxima, so each sample is pushed and popped at most once.
+	The sample that leaves the window is expired before the new one is pushed, so the deque
+	never holds more than lookahead + 1. Its ends are kept in locals for the chunk.
+*/
+		void slidingPeaks(const bufferType* x, bufferType* peaks, size_t count)
+		{
+			bufferType* value = peakValue.data();
+			uint64_t* index = peakIndex.data();
+			const size_t last = lookahead;
+			size_t head = peakHead;
+			size_t size = peakCount;
+			uint64_t now = counter;
+			size_t back = head + size;		// one past the newest
+			back = back > last ? back - last - 1 : back;
+			for (size_t i = 0; i < count; i++)
+			{
+				const bufferType level = std::fabs(x[i]);
+				if (size > 0 && index[head] + lookahead < now)
+				{
+					head = head == last ? 0 : head + 1;
+					size--;
+				}
+				while (size > 0)
+				{
+					const size_t previous = back == 0 ? last : back - 1;
+					if (value[previous] > level)
+						break;
+					back = previous;
+					size--;
+				}
+				value[back] = level;
+				index[back] = now;
+				size++;
+				back = back == last ? 0 : back + 1;
+				peaks[i] = value[head];
+				now++;
+			}
+			peakHead = head;
+			peakCount = size;
+			counter = now;
+		}
+/*===================================================================================*/
+/*
+	[Function] Hold with release, then the running mean over lookahead samples, in place on
+	gain. The sum is kept in double and recomputed once per lap of the ring, so it cannot
+	drift. Reads the ring from position without moving it (delayLine() does).
+*/
+		void smooth(bufferType* gain, size_t count)
+		{
+			bufferType* ring = held.data();
+			const bufferType coefficient = releaseCoefficient;
+			const double scale = 1.0 / static_cast<double>(lookahead);
+			bufferType level = release;
+			double sum = heldSum;
+			size_t p = position;
+			for (size_t i = 0; i < count; i++)
+			{
+				const bufferType target = gain[i];
+				level = target < level ? target : level + coefficient * (target - level);
+				sum += static_cast<double>(level) - static_cast<double>(ring[p]);
+				ring[p] = level;
+				if (++p == lookahead)
+				{
+					p = 0;
+					sum = 0.0;
+					for (size_t k = 0; k < lookahead; k++)
+						sum += static_cast<double>(ring[k]);
+				}
+				gain[i] = static_cast<bufferType>(sum * scale);
+			}
+			release = level;
+			heldSum = sum;
+		}
+
+		void restartGain()
+		{
+			std::fill(held.begin(), held.end(), bufferType(1));
+			release = bufferType(1);
+			heldSum = static_cast<double>(lookahead);
+			peakHead = 0;
+			peakCount = 0;
+		}
+
+		double lookaheadMs = 0.0;
+		double sampleRate = 44100.0;
+		size_t lookahead = 0;
+		bool enabled = false;
+		double ceilingDb = 0.0;
+		bufferType ceiling = 1;
+		double releaseMs = 100.0;
+		bufferType releaseCoefficient = 0;
+
+		std::vector<bufferType> delay;
+		size_t position = 0;			// shared by the delay and held rings
+		std::vector<bufferType> held;
+		bufferType release = 1;
+		double heldSum = 0.0;
+
+		std::vector<bufferType> peakValue;	// deque ring of lookahead + 1
+		std::vector<uint64_t> peakIndex;
+		size_t peakHead = 0;
+		size_t peakCount = 0;
+		uint64_t counter = 0;
+	};
+}
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+#ifndef AuxPort_LockFree_H
+#define AuxPort_LockFree_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Triple buffer: hands whole objects from one producer thread to one consumer
+	thread without locks or allocation. The producer fills write() and calls publish(); the
+	consumer calls update() (usually at the top of a block) and then uses read(). Neither
+	side ever waits, and the consumer never sees a half written object.
+*/
+/*===================================================================================*/
+	template<class T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer() = default;
+		TripleBuffer(const TripleBuffer&) = delete;
+		~TripleBuffer() = default;
+/*===================================================================================*/
+/*
+	[Function] Producer side: the slot to fill next, then hand it over with publish()
+*/
+		T& write()
+		{
+			return slots[back];
+		}
+
+		void publish()
+		{
+			back = middle.exchange(static_cast<uint8_t>(back | fresh), std::memory_order_acq_rel) & index;
+		}
+/*===================================================================================*/
+/*
+	[Function] Consumer side: picks up the newest published slot, true if there was one
+*/
+		bool update()
+		{
+			if ((middle.load(std::memory_order_acquire) & fresh) == 0)
+				return false;
+			front = middle.exchange(front, std::memory_order_acq_rel) & index;
+			return true;
+		}
+
+		const T& read() const
+		{
+			return slots[front];
+		}
+
+		T& read()
+		{
+			return slots[front];
+		}
+/*===================================================================================*/
+/*
+	[Function] Direct slot access for setup before either thread is running
+*/
+		T& slot(int i)
+		{
+			return slots[i];
+		}
+	private:
+		static constexpr uint8_t fresh = 4;
+		static constexpr uint8_t index = 3;
+		T slots[3];
+		uint8_t front = 0;
+		uint8_t back = 1;
+		std::atomic<uint8_t> middle{ 2 };
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Single producer, single consumer ring of plain values. push() and pop() move as
+	many values as fit / are there (two memcpys at most) and never wait or allocate; what
+	doesn't fit is left to the caller (usually dropped). The read and write counters live
+	on separate cache lines, so the two threads don't share one.
+*/
+/*===================================================================================*/
+	template<class T>
+	class SpscRing
+	{
+	public:
+		SpscRing() = default;
+		SpscRing(const SpscRing&) = delete;
+		~SpscRing() = default;
+/*===================================================================================*/
+/*
+	[Function] Room for at least capacity values, empty (allocates; not while either side runs)
+*/
+		void prepare(size_t capacity)
+		{
+			size_t size = 1;
+			while (size < capacity)
+				size <<= 1;
+			slots.assign(size, T());
+			mask = size - 1;
+			written.store(0, std::memory_order_relaxed);
+			consumed.store(0, std::memory_order_relaxed);
+		}
+/*===================================================================================*/
+/*
+	[Function] Producer side: appends up to count values, returns how many
+*/
+		size_t push(const T* values, size_t count)
+		{
+			const size_t head = written.load(std::memory_order_relaxed);
+			const size_t room = slots.size() - (head - consumed.load(std::memory_order_acquire));
+			count = count < room ? count : room;
+			const size_t first = (head & mask) + count <= slots.size() ? count : slots.size() - (head & mask);
+			std::memcpy(slots.data() + (head & mask), values, first * sizeof(T));
+			std::memcpy(slots.data(), values + first, (count - first) * sizeof(T));
+			written.store(head + count, std::memory_order_release);
+			return count;
+		}
+/*===================================================================================*/
+/*
+	[Function] Consumer side: takes up to count values, returns how many
+*/
+		size_t pop(T* values, size_t count)
+		{
+			const size_t tail = consumed.load(std::memory_order_relaxed);
+			const size_t ready = written.load(std::memory_order_acquire) - tail;
+			count = count < ready ? count : ready;
+			const size_t first = (tail & mask) + count <= slots.size() ? count : slots.size() - (tail & mask);
+			std::memcpy(values, slots.data() + (tail & mask), first * sizeof(T));
+			std::memcpy(values + first, slots.data(), (count - first) * sizeof(T));
+			consumed.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		size_t available() const
+		{
+			return written.load(std::memory_order_acquire) - consumed.load(std::memory_order_relaxed);
+		}
+	private:
+		std::vector<T> slots;
+		size_t mask = 0;
+		alignas(64) std::atomic<size_t> written{ 0 };
+		alignas(64) std::atomic<size_t> consumed{ 0 };
+	};
+}
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+#ifndef AuxPort_Parameters_H
+#define AuxPort_Parameters_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "pluginbase.h"
+namespace AuxPort
+{
+	constexpr int maxControlID = 128;
+
+/*===================================================================================*/
+/*
+	[Struct] Everything about a plugin parameter that doesn't change per instance
+	(discrete controls put their comma separated strings in units)
+*/
+/*===================================================================================*/
+	struct ParameterDescriptor
+	{
+		int32_t id;
+		const char* name;
+		const char* units;
+		controlVariableType type;
+		double minimum;
+		double maximum;
+		double defaultValue;
+		taper curve;
+		double smoothingMs;
+		const char* defaultString;
+		bool discreteSwitch;
+		uint32_t guiControlData;
+
+		// --- strings of a discrete control (1 for anything else)
+		constexpr size_t stringCount() const
+		{
+			size_t count = 1;
+			if (type == controlVariableType::kTypedEnumStringList && units)
+			{
+				for (const char* c = units; *c; c++)
+					count += *c == ',';
+			}
+			return count;
+		}
+	};
+
+/*===================================================================================*/
+/*
+	[Class] A constexpr table of descriptors plus the controlID -> slot map built from it at
+	compile time. One table serves every instance; an instance only owns its float values,
+	one per slot, in table order.
+*/
+/*===================================================================================*/
+	template<size_t N>
+	class ParameterTable
+	{
+	public:
+		constexpr ParameterTable(const ParameterDescriptor(&descriptors)[N]) : entries(), slots()
+		{
+			for (int id = 0; id < maxControlID; id++)
+				slots[id] = -1;
+			for (size_t i = 0; i < N; i++)
+			{
+				entries[i] = descriptors[i];
+				if (descriptors[i].id >= 0 && descriptors[i].id < maxControlID)
+					slots[descriptors[i].id] = static_cast<int8_t>(i);
+			}
+		}
+
+		static constexpr size_t size()
+		{
+			return N;
+		}
+
+		constexpr const ParameterDescriptor& operator[](size_t slot) const
+		{
+			return entries[slot];
+		}
+
+		constexpr int slotOf(int32_t id) const
+		{
+			return id >= 0 && id < maxControlID ? slots[id] : -1;
+		}
+
+		int slotOf(const char* name) const
+		{
+			for (size_t i = 0; i < N; i++)
+			{
+				if (std::strcmp(entries[i].name, name) == 0)
+					return static_cast<int>(i);
+			}
+			return -1;
+		}
+
+		const int8_t* slotMap() const
+		{
+			return slots;
+		}
+/*===================================================================================*/
+/*
+	[Function] Writes every default into values (numeric defaults; discrete ones are the index)
+*/
+		void setDefaults(float* values) const
+		{
+			for (size_t i = 0; i < N; i++)
+				values[i] = static_cast<float>(entries[i].defaultValue);
+		}
+	private:
+		ParameterDescriptor entries[N];
+		int8_t slots[maxControlID];
+	};
+
+/*===================================================================================*/
+/*
+	[Struct] What an Effect reads its controls through: one instance's contiguous values and
+	the shared slot map. get() is two loads instead of a search.
+*/
+/*===================================================================================*/
+	struct ControlBlock
+	{
+		float* values = nullptr;
+		const int8_t* slots = nullptr;
+
+		float get(int id) const
+		{
+			int slot = id >= 0 && id < maxControlID && slots ? slots[id] : -1;
+			return slot < 0 ? 0.0f : values[slot];
+		}
+
+		void set(int id, float value)
+		{
+			int slot = id >= 0 && id < maxControlID && slots ? slots[id] : -1;
+			if (slot >= 0)
+				values[slot] = value;
+		}
+	};
+}
+#endif
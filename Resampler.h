@@ -0,0 +1,199 @@
+#pragma once
+#ifndef AuxPort_Resampler_H
+#define AuxPort_Resampler_H
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "Snapshot.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Streaming rational polyphase resampler
+
+	Converts between integer sample rates by L/M (the reduced ratio). The prototype is a
+	Kaiser windowed sinc with taps coefficients per phase, cut off a little below the lower
+	of the two Nyquist rates. Each phase's coefficients are stored reversed and the input
+	history is kept twice, so every output sample is one contiguous dot product the
+	compiler vectorizes. Phase tables are built once per (L, M, taps) and shared by every
+	resampler in the process; prepare() is where that happens, so call it from reset(),
+	never from the audio thread.
+*/
+/*===================================================================================*/
+	template<class T>
+	class Resampler
+	{
+	public:
+		static constexpr size_t maxPhases = 4096;
+		Resampler() = default;
+		Resampler(const Resampler&) = default;
+		~Resampler() = default;
+/*===================================================================================*/
+/*
+	[Function] Sets up fromRate -> toRate (rounded to whole Hz); false if the reduced ratio
+	needs more than maxPhases phases
+*/
+		bool prepare(double fromRate, double toRate, size_t tapsPerPhase = 32)
+		{
+			uint64_t from = static_cast<uint64_t>(std::llround(fromRate));
+			uint64_t to = static_cast<uint64_t>(std::llround(toRate));
+			if (from == 0 || to == 0 || tapsPerPhase == 0)
+				return false;
+			uint64_t divisor = gcd(from, to);
+			up = static_cast<size_t>(to / divisor);
+			down = static_cast<size_t>(from / divisor);
+			if (up > maxPhases)
+				return false;
+			taps = tapsPerPhase;
+			table = cachedTable(up, down, taps);
+			history.assign(2 * taps, T(0));
+			position = 0;
+			phase = 0;
+			return true;
+		}
+
+		void reset()
+		{
+			std::fill(history.begin(), history.end(), T(0));
+			position = 0;
+			phase = 0;
+		}
+/*===================================================================================*/
+/*
+	[Function] Most samples process() can produce from numInput samples
+*/
+		size_t maxOutput(size_t numInput) const
+		{
+			return down == 0 ? 0 : (numInput * up) / down + 2;
+		}
+/*===================================================================================*/
+/*
+	[Function] Consumes numInput samples, appends the produced ones to output, returns how many
+*/
+		size_t process(const T* input, size_t numInput, T* output)
+		{
+			const T* coefficients = table->data();
+			size_t produced = 0;
+			for (size_t i = 0; i < numInput; i++)
+			{
+				history[position] = input[i];
+				history[position + taps] = input[i];
+				position = position + 1 == taps ? 0 : position + 1;
+				const T* window = history.data() + position;
+				while (phase < up)
+				{
+					const T* h = coefficients + phase * taps;
+					T sum = T(0);
+					for (size_t k = 0; k < taps; k++)
+						sum += h[k] * window[k];
+					output[produced++] = sum;
+					phase += down;
+				}
+				phase -= up;
+			}
+			return produced;
+		}
+/*===================================================================================*/
+/*
+	[Function] Group delay in output samples
+*/
+		double latency() const
+		{
+			return down == 0 ? 0.0 : (static_cast<double>(taps * up) - 1.0) / (2.0 * down);
+		}
+/*===================================================================================*/
+/*
+	[Function] Writes the ratio and the input history; restore() only accepts a snapshot of
+	the same ratio and taps, so it never has to build (or look up) a phase table
+*/
+		void save(StateWriter& writer) const
+		{
+			writer.write(static_cast<uint32_t>(up));
+			writer.write(static_cast<uint32_t>(down));
+			writer.write(static_cast<uint32_t>(taps));
+			writer.write(static_cast<uint32_t>(position));
+			writer.write(static_cast<uint32_t>(phase));
+			writer.write(history.data(), history.size());
+		}
+
+		bool restore(StateReader& reader)
+		{
+			uint32_t ratio[5] = {};
+			if (!reader.read(ratio, 5) || ratio[0] != up || ratio[1] != down || ratio[2] != taps || ratio[3] >= taps || ratio[4] >= down)
+				return false;
+			position = ratio[3];
+			phase = ratio[4];
+			return reader.read(history.data(), history.size());
+		}
+	private:
+		static uint64_t gcd(uint64_t a, uint64_t b)
+		{
+			while (b != 0)
+			{
+				uint64_t r = a % b;
+				a = b;
+				b = r;
+			}
+			return a;
+		}
+
+		static double besselI0(double x)
+		{
+			double sum = 1.0, term = 1.0;
+			for (int k = 1; k < 40; k++)
+			{
+				term *= (x / (2.0 * k)) * (x / (2.0 * k));
+				sum += term;
+			}
+			return sum;
+		}
+
+		static std::shared_ptr<const std::vector<T>> cachedTable(size_t up, size_t down, size_t taps)
+		{
+			static std::mutex mutex;
+			static std::map<std::tuple<size_t, size_t, size_t>, std::shared_ptr<const std::vector<T>>> cache;
+			std::lock_guard<std::mutex> lock(mutex);
+			auto& entry = cache[std::make_tuple(up, down, taps)];
+			if (!entry)
+				entry = build(up, down, taps);
+			return entry;
+		}
+
+		static std::shared_ptr<const std::vector<T>> build(size_t up, size_t down, size_t taps)
+		{
+			const double pi = 3.14159265358979323846;
+			const size_t length = up * taps;
+			const double cutoff = 0.5 * 0.92 / static_cast<double>(up > down ? up : down);
+			const double beta = 9.0;
+			const double centre = (static_cast<double>(length) - 1.0) / 2.0;
+			const double normalizer = besselI0(beta);
+			auto phases = std::make_shared<std::vector<T>>(length);
+			for (size_t j = 0; j < length; j++)
+			{
+				double x = static_cast<double>(j) - centre;
+				double sinc = x == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * x) / (pi * x);
+				double r = x / (centre + 1.0);
+				double window = besselI0(beta * std::sqrt(1.0 - r * r)) / normalizer;
+				size_t p = j % up;
+				size_t k = j / up;
+				(*phases)[p * taps + (taps - 1 - k)] = static_cast<T>(static_cast<double>(up) * sinc * window);
+			}
+			return phases;
+		}
+
+		std::shared_ptr<const std::vector<T>> table;
+		std::vector<T> history;
+		size_t taps = 0;
+		size_t up = 1;
+		size_t down = 1;
+		size_t position = 0;
+		size_t phase = 0;
+	};
+}
+#endif
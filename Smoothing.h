@@ -0,0 +1,138 @@
+#pragma once
+#ifndef AuxPort_Smoothing_H
+#define AuxPort_Smoothing_H
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include "Parameters.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Block rate parameter smoothing for every slot of a ParameterTable at once
+
+	The smoothers are kept structure-of-arrays (value, target, increment, samples left),
+	so advance() is a handful of branch free loops over N floats that the compiler
+	vectorizes. Ramps are linear over each descriptor's smoothingMs and land exactly on
+	the target, after which the slot costs nothing: when no slot is moving, advance() only
+	checks a flag. Discrete switches and slots without a smoothing time jump.
+
+	retarget() picks up new targets (the host's bound values, once per buffer). advance()
+	moves every ramp on by the samples about to be processed, and the kernel reads values()
+	once for them: per sub-block in the block path, per frame in the frame path. The block
+	path ramps its gains from the last sub-block's values to these across the sub-block
+	(Effect::cookGains), so a ramp never steps.
+*/
+/*===================================================================================*/
+	template<size_t N>
+	class SmoothingEngine
+	{
+	public:
+		SmoothingEngine() = default;
+/*===================================================================================*/
+/*
+	[Function] Ramp lengths for sampleRate, and every value jumps to its target
+*/
+		void prepare(const ParameterTable<N>& table, double sampleRate, const float* targets)
+		{
+			for (size_t i = 0; i < N; i++)
+			{
+				const double samples = table[i].discreteSwitch ? 0.0 : std::round(table[i].smoothingMs * 0.001 * sampleRate);
+				rampLength[i] = samples > 1.0 ? static_cast<float>(samples) : 0.0f;
+			}
+			jump(targets);
+		}
+
+		void jump(const float* targets)
+		{
+			std::memcpy(target, targets, sizeof(target));
+			std::memcpy(current, targets, sizeof(current));
+			for (size_t i = 0; i < N; i++)
+			{
+				increment[i] = 0.0f;
+				remaining[i] = 0.0f;
+			}
+			moving = false;
+		}
+/*===================================================================================*/
+/*
+	[Function] Starts a ramp, from wherever the value is now, for every target that moved;
+	true if any did
+*/
+		bool retarget(const float* targets)
+		{
+			bool changed = false;
+			for (size_t i = 0; i < N; i++)
+				changed |= targets[i] != target[i];
+			if (!changed)
+				return false;
+			for (size_t i = 0; i < N; i++)
+			{
+				if (targets[i] == target[i])
+					continue;
+				target[i] = targets[i];
+				if (rampLength[i] > 0.0f)
+				{
+					increment[i] = (target[i] - current[i]) / rampLength[i];
+					remaining[i] = rampLength[i];
+				}
+				else
+				{
+					current[i] = target[i];
+					increment[i] = 0.0f;
+					remaining[i] = 0.0f;
+				}
+			}
+			moving = true;
+			return true;
+		}
+/*===================================================================================*/
+/*
+	[Function] Moves every ramp on by numSamples; false (and nothing touched) when all the
+	values have settled
+*/
+		bool advance(size_t numSamples)
+		{
+			if (!moving)
+				return false;
+			const float n = static_cast<float>(numSamples);
+			for (size_t i = 0; i < N; i++)
+			{
+				const bool done = remaining[i] <= n;
+				current[i] = done ? target[i] : current[i] + n * increment[i];
+				remaining[i] = done ? 0.0f : remaining[i] - n;
+			}
+			float left = 0.0f;
+			for (size_t i = 0; i < N; i++)
+				left += remaining[i];
+			moving = left > 0.0f;
+			return true;
+		}
+
+		bool isMoving() const
+		{
+			return moving;
+		}
+/*===================================================================================*/
+/*
+	[Function] Current values, one per slot
+*/
+		float* values()
+		{
+			return current;
+		}
+
+		const float* values() const
+		{
+			return current;
+		}
+	private:
+		float current[N] = {};
+		float target[N] = {};
+		float increment[N] = {};
+		float remaining[N] = {};
+		float rampLength[N] = {};
+		bool moving = false;
+	};
+}
+#endif
@@ -0,0 +1,125 @@
+#pragma once
+#ifndef AuxPort_Snapshot_H
+#define AuxPort_Snapshot_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Appends plain values to a byte vector for a state snapshot. The vector is only
+	cleared, never shrunk, so once it has the capacity of one snapshot, taking the next one
+	does not allocate. Values are stored in native layout: a snapshot is for the same build
+	on the same machine (a clone, a pool), not a file format. A bool is stored as one byte,
+	0 or 1, so a reader can check it; structs holding one are written field by field.
+*/
+/*===================================================================================*/
+	class StateWriter
+	{
+	public:
+		explicit StateWriter(std::vector<uint8_t>& bytes) : bytes(bytes)
+		{
+			bytes.clear();
+		}
+
+		template<class T>
+		void write(const T& value)
+		{
+			write(&value, 1);
+		}
+
+		void write(const bool& value)
+		{
+			write(static_cast<uint8_t>(value ? 1 : 0));
+		}
+
+		template<class T>
+		void write(const T* values, size_t count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "StateWriter only writes trivially copyable values");
+			static_assert(!std::is_same<T, bool>::value, "StateWriter writes bools one at a time");
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(values);
+			bytes.insert(bytes.end(), data, data + count * sizeof(T));
+		}
+/*===================================================================================*/
+/*
+	[Function] Overwrites a value written earlier (e.g. a length field) at offset
+*/
+		template<class T>
+		void overwrite(size_t offset, const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "StateWriter only writes trivially copyable values");
+			std::memcpy(bytes.data() + offset, &value, sizeof(T));
+		}
+
+		size_t size() const
+		{
+			return bytes.size();
+		}
+	private:
+		std::vector<uint8_t>& bytes;
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Reads back what a StateWriter wrote. A read past the end, or a bool byte other
+	than 0 or 1, fails and leaves the reader failed, so a restore can read everything and
+	check good() once.
+*/
+/*===================================================================================*/
+	class StateReader
+	{
+	public:
+		StateReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+		template<class T>
+		bool read(T& value)
+		{
+			return read(&value, 1);
+		}
+
+		bool read(bool& value)
+		{
+			uint8_t byte = 0;
+			if (!read(byte) || byte > 1)
+				return ok = false;
+			value = byte == 1;
+			return true;
+		}
+
+		template<class T>
+		bool read(T* values, size_t count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "StateReader only reads trivially copyable values");
+			static_assert(!std::is_same<T, bool>::value, "StateReader reads bools one at a time");
+			const size_t length = count * sizeof(T);
+			if (!ok || size - offset < length)
+				return ok = false;
+			std::memcpy(values, data + offset, length);
+			offset += length;
+			return true;
+		}
+
+		bool good() const
+		{
+			return ok;
+		}
+/*===================================================================================*/
+/*
+	[Function] True if every byte was read and nothing failed
+*/
+		bool done() const
+		{
+			return ok && offset == size;
+		}
+	private:
+		const uint8_t* data;
+		size_t size;
+		size_t offset = 0;
+		bool ok = true;
+	};
+}
+#endif
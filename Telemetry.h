@@ -0,0 +1,442 @@
+#pragma once
+#ifndef AuxPort_Telemetry_H
+#define AuxPort_Telemetry_H
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "BackgroundWorker.h"
+#include "Governor.h"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Function] CPU time consumed by the calling thread, in nanoseconds
+*/
+/*===================================================================================*/
+	inline uint64_t threadCpuTimeNs()
+	{
+#if defined(_WIN32)
+		FILETIME creation, exit, kernelTime, userTime;
+		if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernelTime, &userTime))
+			return 0;
+		uint64_t k = (static_cast<uint64_t>(kernelTime.dwHighDateTime) << 32) | kernelTime.dwLowDateTime;
+		uint64_t u = (static_cast<uint64_t>(userTime.dwHighDateTime) << 32) | userTime.dwLowDateTime;
+		return (k + u) * 100;
+#else
+		timespec now;
+		if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0)
+			return 0;
+		return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+#endif
+	}
+
+/*===================================================================================*/
+/*
+	[Class] HDR style histogram of non-negative integers
+
+	Values below 32 get a bucket each; above that every power of two is split into 16
+	buckets, so a value is counted within 1/16 of itself. Values from 2^maxBits up (18
+	minutes in nanoseconds) share the last bucket. record() is
+	for one writer thread (it is a relaxed load and store per count, no locked instruction);
+	any thread may read a snapshot while it runs.
+*/
+/*===================================================================================*/
+	class Histogram
+	{
+	public:
+		static constexpr int subBucketBits = 4;
+		static constexpr size_t subBuckets = size_t(1) << subBucketBits;
+		static constexpr int maxBits = 40;
+		static constexpr size_t numBuckets = 2 * subBuckets + (maxBits - 1 - subBucketBits) * subBuckets;
+
+		Histogram() = default;
+		Histogram(const Histogram&) = delete;
+
+		void record(uint64_t value)
+		{
+			std::atomic<uint64_t>& count = counts[bucketOf(value)];
+			count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		static size_t bucketOf(uint64_t value)
+		{
+			if (value < 2 * subBuckets)
+				return static_cast<size_t>(value);
+			if (value >> maxBits)
+				return numBuckets - 1;
+			int top = maxBits - 1;
+			while ((value >> top) == 0)
+				top--;
+			const int shift = top - subBucketBits;
+			return 2 * subBuckets + static_cast<size_t>(shift - 1) * subBuckets + static_cast<size_t>((value >> shift) - subBuckets);
+		}
+/*===================================================================================*/
+/*
+	[Function] Smallest value counted in a bucket
+*/
+		static uint64_t lowerBound(size_t bucket)
+		{
+			if (bucket < 2 * subBuckets)
+				return bucket;
+			const size_t shift = (bucket - 2 * subBuckets) / subBuckets + 1;
+			const uint64_t mantissa = subBuckets + (bucket - 2 * subBuckets) % subBuckets;
+			return mantissa << shift;
+		}
+/*===================================================================================*/
+/*
+	[Class] Plain copy of the counts, taken off the audio thread
+*/
+		struct Snapshot
+		{
+			uint64_t counts[numBuckets] = {};
+			uint64_t total = 0;
+/*===================================================================================*/
+/*
+	[Function] Lower bound of the bucket holding quantile q (0..1), 0 when empty
+*/
+			uint64_t quantile(double q) const
+			{
+				if (total == 0)
+					return 0;
+				uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1));
+				uint64_t seen = 0;
+				for (size_t i = 0; i < numBuckets; i++)
+				{
+					seen += counts[i];
+					if (seen > rank)
+						return lowerBound(i);
+				}
+				return lowerBound(numBuckets - 1);
+			}
+		};
+
+		void snapshot(Snapshot& out) const
+		{
+			out.total = 0;
+			for (size_t i = 0; i < numBuckets; i++)
+			{
+				out.counts[i] = counts[i].load(std::memory_order_relaxed);
+				out.total += out.counts[i];
+			}
+		}
+	private:
+		std::atomic<uint64_t> counts[numBuckets] = {};
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Per-callback timing against the real-time deadline
+
+	begin()/end() bracket one host callback on the audio thread. end() records the wall
+	clock and thread CPU time of the callback and its load (wall time / deadline, in
+	thousandths) into histograms, and counts near misses (load at or above nearMissLoad)
+	and overruns (load above 1). Nothing blocks or allocates; every figure is readable
+	from any thread.
+*/
+/*===================================================================================*/
+	class CallbackTelemetry
+	{
+	public:
+		CallbackTelemetry() = default;
+		CallbackTelemetry(const CallbackTelemetry&) = delete;
+
+		void begin()
+		{
+			startedWall = std::chrono::steady_clock::now();
+			startedCpu = threadCpuTimeNs();
+		}
+/*===================================================================================*/
+/*
+	[Function] Ends the callback; returns its load (0 if the buffer was empty)
+*/
+		double end(size_t numSamples, double sampleRate)
+		{
+			const uint64_t cpu = threadCpuTimeNs() - startedCpu;
+			const uint64_t wall = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startedWall).count());
+			if (numSamples == 0 || sampleRate <= 0)
+				return 0.0;
+			const double deadline = static_cast<double>(numSamples) * 1e9 / sampleRate;
+			const double load = static_cast<double>(wall) / deadline;
+			wallNs.record(wall);
+			cpuNs.record(cpu);
+			loadPermille.record(static_cast<uint64_t>(load * 1000.0 + 0.5));
+			bump(callbacks);
+			if (load > 1.0)
+				bump(overruns);
+			else if (load >= nearMissLoad.load(std::memory_order_relaxed))
+				bump(nearMisses);
+			if (load > worstLoad.load(std::memory_order_relaxed))
+				worstLoad.store(load, std::memory_order_relaxed);
+			return load;
+		}
+
+		Histogram wallNs;
+		Histogram cpuNs;
+		Histogram loadPermille;
+		std::atomic<uint64_t> callbacks{ 0 };
+		std::atomic<uint64_t> nearMisses{ 0 };
+		std::atomic<uint64_t> overruns{ 0 };
+		std::atomic<double> worstLoad{ 0.0 };
+		std::atomic<double> nearMissLoad{ 0.8 };
+	private:
+		static void bump(std::atomic<uint64_t>& counter)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		std::chrono::steady_clock::time_point startedWall;
+		uint64_t startedCpu = 0;
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Exports a CallbackTelemetry (and optionally a LoadGovernor) as text on the
+	shared BackgroundWorker
+
+	The target is a file path, rewritten whole each time through a temporary and a rename
+	so a scraper never reads half of it, or "unix:<path>" to send each report to a Unix
+	stream socket (POSIX only; a reader that is gone or doesn't keep up costs the shared
+	worker at most sendTimeoutMs and an export error, never a SIGPIPE). The audio thread
+	calls tick() once per callback; it only counts samples and, once per interval, makes
+	the single atomic store that asks the worker for a report. One "name value" pair per
+	line:
+
+		auxport_callbacks 48213
+		auxport_overruns 2
+		auxport_load_p99 0.412
+		auxport_load_bucket{le="0.500"} 48100
+		...
+*/
+/*===================================================================================*/
+	class TelemetryExporter : public BackgroundTask
+	{
+	public:
+		TelemetryExporter(const CallbackTelemetry& telemetry, const LoadGovernor* governor = nullptr) : telemetry(telemetry), governor(governor) {}
+		~TelemetryExporter()
+		{
+			stop();
+		}
+/*===================================================================================*/
+/*
+	[Function] Starts exporting to target every intervalMs of audio (not from the audio
+	thread); false if target is empty or names a socket on a platform without them
+*/
+		bool start(const std::string& newTarget, unsigned intervalMs = 1000)
+		{
+			stop();
+			if (newTarget.empty())
+				return false;
+#if defined(_WIN32)
+			if (newTarget.compare(0, 5, "unix:") == 0)
+				return false;
+#endif
+			target = newTarget;
+			interval = intervalMs;
+			samplesSinceReport = 0;
+			BackgroundWorker::get().attach(this);
+			attached = true;
+			return true;
+		}
+
+		void stop()
+		{
+			if (!attached)
+				return;
+			BackgroundWorker::get().detach(this);
+			attached = false;
+		}
+/*===================================================================================*/
+/*
+	[Function] Audio thread: counts the callback's samples toward the export interval
+*/
+		void tick(size_t numSamples, double sampleRate)
+		{
+			if (!attached)
+				return;
+			samplesSinceReport += numSamples;
+			if (static_cast<double>(samplesSinceReport) * 1000.0 >= interval * sampleRate)
+			{
+				samplesSinceReport = 0;
+				requestService();
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] The report as text (any thread)
+*/
+		std::string report() const
+		{
+			std::ostringstream text;
+			text << "auxport_timestamp_seconds " << std::time(nullptr) << "\n";
+			text << "auxport_callbacks " << telemetry.callbacks.load() << "\n";
+			text << "auxport_near_misses " << telemetry.nearMisses.load() << "\n";
+			text << "auxport_overruns " << telemetry.overruns.load() << "\n";
+			text << "auxport_load_worst " << telemetry.worstLoad.load() << "\n";
+			std::unique_ptr<Histogram::Snapshot[]> snapshots(new Histogram::Snapshot[3]);
+			Histogram::Snapshot& load = snapshots[0];
+			Histogram::Snapshot& wall = snapshots[1];
+			Histogram::Snapshot& cpu = snapshots[2];
+			telemetry.loadPermille.snapshot(load);
+			telemetry.wallNs.snapshot(wall);
+			telemetry.cpuNs.snapshot(cpu);
+			for (double q : { 0.5, 0.9, 0.99, 0.999 })
+			{
+				std::string suffix = quantileSuffix(q);
+				text << "auxport_load_" << suffix << " " << static_cast<double>(load.quantile(q)) / 1000.0 << "\n";
+				text << "auxport_wall_ns_" << suffix << " " << wall.quantile(q) << "\n";
+				text << "auxport_cpu_ns_" << suffix << " " << cpu.quantile(q) << "\n";
+			}
+			uint64_t cumulative = 0;
+			for (size_t i = 0; i < Histogram::numBuckets; i++)
+			{
+				if (load.counts[i] == 0)
+					continue;
+				cumulative += load.counts[i];
+				char bound[32] = "+Inf";
+				if (i + 1 < Histogram::numBuckets)
+					std::snprintf(bound, sizeof(bound), "%.3f", static_cast<double>(Histogram::lowerBound(i + 1)) / 1000.0);
+				text << "auxport_load_bucket{le=\"" << bound << "\"} " << cumulative << "\n";
+			}
+			if (governor)
+			{
+				const LoadGovernor::Metrics& metrics = governor->getMetrics();
+				text << "auxport_tier " << metrics.tier.load() << "\n";
+				text << "auxport_tier_step_downs " << metrics.stepDowns.load() << "\n";
+				text << "auxport_tier_step_ups " << metrics.stepUps.load() << "\n";
+			}
+			text << "auxport_export_errors " << exportErrors.load() << "\n";
+			return text.str();
+		}
+
+		std::atomic<uint64_t> exportErrors{ 0 };
+		static constexpr int sendTimeoutMs = 100;
+	private:
+		void service() override
+		{
+			if (!(target.compare(0, 5, "unix:") == 0 ? sendToSocket(target.substr(5), report()) : writeToFile(target, report())))
+				exportErrors.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		static bool writeToFile(const std::string& path, const std::string& text)
+		{
+			const std::string temporary = path + ".tmp";
+			{
+				std::ofstream file(temporary, std::ios::trunc);
+				if (!file)
+					return false;
+				file << text;
+				if (!file)
+					return false;
+			}
+#if defined(_WIN32)
+			std::remove(path.c_str());
+#endif
+			return std::rename(temporary.c_str(), path.c_str()) == 0;
+		}
+
+		static bool sendToSocket(const std::string& path, const std::string& text)
+		{
+#if defined(_WIN32)
+			(void)path;
+			(void)text;
+			return false;
+#else
+			sockaddr_un address = {};
+			if (path.size() >= sizeof(address.sun_path))
+				return false;
+			address.sun_family = AF_UNIX;
+			path.copy(address.sun_path, path.size());
+			int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (fd < 0)
+				return false;
+#if defined(SO_NOSIGPIPE)
+			const int on = 1;
+			setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+#if defined(MSG_NOSIGNAL)
+			const int flags = MSG_NOSIGNAL;
+#else
+			const int flags = 0;
+#endif
+			// non-blocking: the worker is shared, so a full backlog or buffer is waited for only
+			// up to the deadline
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(sendTimeoutMs);
+			const int status = fcntl(fd, F_GETFL);
+			bool sent = status >= 0 && fcntl(fd, F_SETFL, status | O_NONBLOCK) == 0;
+			if (sent && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+			{
+				int error = 0;
+				socklen_t size = sizeof(error);
+				sent = errno == EINPROGRESS && waitWritable(fd, deadline) && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) == 0 && error == 0;
+			}
+			for (size_t offset = 0; sent && offset < text.size();)
+			{
+				const ssize_t n = send(fd, text.data() + offset, text.size() - offset, flags);
+				if (n > 0)
+					offset += static_cast<size_t>(n);
+				else
+					sent = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) && waitWritable(fd, deadline);
+			}
+			close(fd);
+			return sent;
+#endif
+		}
+#if !defined(_WIN32)
+/*===================================================================================*/
+/*
+	[Function] Waits until fd takes more data, false once deadline has passed
+*/
+		static bool waitWritable(int fd, std::chrono::steady_clock::time_point deadline)
+		{
+			for (;;)
+			{
+				const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+				if (left <= 0)
+					return false;
+				pollfd entry = { fd, POLLOUT, 0 };
+				const int ready = poll(&entry, 1, static_cast<int>(left));
+				if (ready > 0)
+					return (entry.revents & POLLOUT) != 0;
+				if (ready == 0 || errno != EINTR)
+					return false;
+			}
+		}
+#endif
+
+		static std::string quantileSuffix(double q)
+		{
+			return q == 0.5 ? "p50" : (q == 0.9 ? "p90" : (q == 0.99 ? "p99" : "p999"));
+		}
+
+		const CallbackTelemetry& telemetry;
+		const LoadGovernor* governor;
+		std::string target;
+		double interval = 1000;
+		size_t samplesSinceReport = 0;
+		bool attached = false;
+	};
+}
+#endif
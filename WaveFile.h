@@ -0,0 +1,263 @@
+#pragma once
+#ifndef AuxPort_WaveFile_H
+#define AuxPort_WaveFile_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Formats.h"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Class] Read only memory mapped file (CreateFileMapping on Windows, mmap elsewhere).
+	The pages are only read in as they are touched, so parsing a long impulse response or
+	a batch input costs no copy of the file image. Empty files don't map.
+*/
+/*===================================================================================*/
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile()
+		{
+			close();
+		}
+
+		bool open(const std::string& path)
+		{
+			close();
+#if defined(_WIN32)
+			file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+			{
+				close();
+				return false;
+			}
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping == nullptr)
+			{
+				close();
+				return false;
+			}
+			view = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			length = static_cast<size_t>(fileSize.QuadPart);
+#else
+			const int descriptor = ::open(path.c_str(), O_RDONLY);
+			if (descriptor < 0)
+				return false;
+			struct stat status;
+			if (fstat(descriptor, &status) != 0 || status.st_size <= 0)
+			{
+				::close(descriptor);
+				return false;
+			}
+			void* address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+			::close(descriptor);
+			if (address == MAP_FAILED)
+				return false;
+			view = static_cast<const uint8_t*>(address);
+			length = static_cast<size_t>(status.st_size);
+#endif
+			if (view == nullptr)
+			{
+				close();
+				return false;
+			}
+			return true;
+		}
+
+		void close()
+		{
+#if defined(_WIN32)
+			if (view)
+				UnmapViewOfFile(view);
+			if (mapping)
+				CloseHandle(mapping);
+			if (file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+			mapping = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if (view)
+				munmap(const_cast<uint8_t*>(view), length);
+#endif
+			view = nullptr;
+			length = 0;
+		}
+
+		const uint8_t* data() const
+		{
+			return view;
+		}
+
+		size_t size() const
+		{
+			return length;
+		}
+	private:
+		const uint8_t* view = nullptr;
+		size_t length = 0;
+#if defined(_WIN32)
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#endif
+	};
+
+/*===================================================================================*/
+/*
+	[Struct] Minimal RIFF/WAVE container [PCM 16/24/32 bit and 32 bit float in, 32 bit float out]
+*/
+	struct WaveFile
+	{
+		uint32_t sampleRate = 44100;
+		uint32_t channels = 0;
+		std::vector<float> samples;		// interleaved
+
+		size_t frames() const
+		{
+			return channels == 0 ? 0 : samples.size() / channels;
+		}
+/*===================================================================================*/
+/*
+	[Function] Parses a complete WAV image that is already in memory
+*/
+		bool parse(const uint8_t* data, size_t size)
+		{
+			if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+				return false;
+			uint16_t format = 0;
+			uint16_t bitsPerSample = 0;
+			size_t position = 12;
+			while (position + 8 <= size)
+			{
+				const uint8_t* chunk = data + position;
+				uint32_t chunkSize = readLE32(chunk + 4);
+				const uint8_t* body = chunk + 8;
+				size_t available = size - position - 8;
+				if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && available >= 16)
+				{
+					format = readLE16(body);
+					channels = readLE16(body + 2);
+					sampleRate = readLE32(body + 4);
+					bitsPerSample = readLE16(body + 14);
+					if (format == 0xFFFE && chunkSize >= 26 && available >= 26)
+						format = readLE16(body + 24);
+				}
+				else if (std::memcmp(chunk, "data", 4) == 0)
+				{
+					if (channels == 0 || bitsPerSample == 0)
+						return false;
+					size_t bytes = chunkSize < available ? chunkSize : available;
+					return decode(body, bytes, format, bitsPerSample);
+				}
+				position += 8 + static_cast<size_t>(chunkSize) + (chunkSize & 1);
+			}
+			return false;
+		}
+/*===================================================================================*/
+/*
+	[Function] Loads and parses a WAV file from disk (mapped, not copied, before decoding)
+*/
+		bool read(const std::string& path)
+		{
+			MappedFile file;
+			return file.open(path) && parse(file.data(), file.size());
+		}
+/*===================================================================================*/
+/*
+	[Function] Writes the samples as a 32 bit float WAV file
+*/
+		bool write(const std::string& path) const
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			if (!file)
+				return false;
+			uint32_t dataBytes = static_cast<uint32_t>(samples.size() * sizeof(float));
+			uint8_t header[44];
+			std::memcpy(header, "RIFF", 4);
+			writeLE32(header + 4, 36 + dataBytes);
+			std::memcpy(header + 8, "WAVEfmt ", 8);
+			writeLE32(header + 16, 16);
+			writeLE16(header + 20, 3);
+			writeLE16(header + 22, static_cast<uint16_t>(channels));
+			writeLE32(header + 24, sampleRate);
+			writeLE32(header + 28, sampleRate * channels * sizeof(float));
+			writeLE16(header + 32, static_cast<uint16_t>(channels * sizeof(float)));
+			writeLE16(header + 34, 32);
+			std::memcpy(header + 36, "data", 4);
+			writeLE32(header + 40, dataBytes);
+			file.write(reinterpret_cast<const char*>(header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(samples.data()), dataBytes);
+			return static_cast<bool>(file);
+		}
+	private:
+		bool decode(const uint8_t* body, size_t bytes, uint16_t format, uint16_t bitsPerSample)
+		{
+			size_t width = bitsPerSample / 8;
+			if (width == 0)
+				return false;
+			size_t count = bytes / width;
+			count -= count % channels;
+			samples.resize(count);
+			if (format == 3 && bitsPerSample == 32)
+			{
+				std::memcpy(samples.data(), body, count * sizeof(float));
+				return true;
+			}
+			if (format != 1)
+				return false;
+			if (bitsPerSample == 16 || bitsPerSample == 24)
+			{
+				SampleFormat sampleFormat = bitsPerSample == 16 ? SampleFormat::Int16 : SampleFormat::Int24;
+				Interleaved<float>::read(body, sampleFormat, 1, 0, count, samples.data());
+				return true;
+			}
+			if (bitsPerSample != 32)
+				return false;
+			for (size_t i = 0; i < count; i++)
+				samples[i] = static_cast<int32_t>(readLE32(body + i * width)) * (1.0f / 2147483648.0f);
+			return true;
+		}
+		static uint16_t readLE16(const uint8_t* p)
+		{
+			return static_cast<uint16_t>(p[0] | (p[1] << 8));
+		}
+		static uint32_t readLE32(const uint8_t* p)
+		{
+			return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+		}
+		static void writeLE16(uint8_t* p, uint16_t v)
+		{
+			p[0] = static_cast<uint8_t>(v);
+			p[1] = static_cast<uint8_t>(v >> 8);
+		}
+		static void writeLE32(uint8_t* p, uint32_t v)
+		{
+			for (int i = 0; i < 4; i++)
+				p[i] = static_cast<uint8_t>(v >> (8 * i));
+		}
+	};
+}
+#endif
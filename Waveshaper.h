@@ -0,0 +1,271 @@
+#pragma once
+#ifndef AuxPort_Waveshaper_H
+#define AuxPort_Waveshaper_H
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "BackgroundWorker.h"
+#include "LockFree.h"
+namespace AuxPort
+{
+/*===================================================================================*/
+/*
+	[Enum] The FX shaping curves a TableShaper can bake. alpha is the drive for the arc
+	tangents and the threshold for ZeroCrossing; Halfwave and Fullwave ignore it.
+*/
+/*===================================================================================*/
+	enum class Curve
+	{
+		ArcTan1, ArcTan2, ArcTanH, ZeroCrossing, Halfwave, Fullwave, Custom
+	};
+
+	enum class Interpolation
+	{
+		Linear, Cubic
+	};
+
+/*===================================================================================*/
+/*
+	[Class] Table driven waveshaper
+
+	- the curve is sampled over [-inputRange, inputRange]. For the arc tangents that is the
+	  range of alpha * x, so the resolution doesn't depend on alpha; ArcTanH's table spans
+	  the (-1, 1) of its argument and ZeroCrossing's reaches past the threshold
+	- outside the table the rectifiers and ZeroCrossing continue with the edge slope (they
+	  are linear there), the arc tangents approach their asymptote as 1/x like the curve
+	  does, and ArcTanH and Custom hold their edge value, so no saturator is unbounded
+	- when alpha (or the curve) changes, the new table is built on the BackgroundWorker and
+	  swapped in at the next process() call; until then the previous table is used
+	- the output gain (the FX "mix") is applied at lookup, so it never forces a rebuild
+	- Custom takes any f(x, alpha), e.g. a curve drawn in the GUI, at the same per-sample cost
+
+	ArcTanH is baked with its argument clamped just inside (-1, 1) so the table stays finite,
+	and ZeroCrossing's hard step is spread over one table step by the interpolation.
+*/
+/*===================================================================================*/
+	template<class T>
+	class TableShaper : public BackgroundTask
+	{
+	public:
+		TableShaper(Curve curve = Curve::ArcTan1, T alpha = T(1), size_t tableSize = 2048, T inputRange = T(4), Interpolation interpolation = Interpolation::Linear)
+			: tableSize(tableSize < 4 ? 4 : tableSize), inputRange(inputRange), interpolation(interpolation)
+		{
+			requestedCurve = curve;
+			requestedAlpha = alpha;
+			for (int i = 0; i < 3; i++)
+				tables.slot(i).values.reserve(this->tableSize + 3);
+			build(tables.read(), curve, alpha);
+			audioAlpha = alpha;
+			BackgroundWorker::get().attach(this);
+		}
+		TableShaper(const TableShaper&) = delete;
+		~TableShaper()
+		{
+			BackgroundWorker::get().detach(this);
+		}
+/*===================================================================================*/
+/*
+	[Function] Control thread: switch curve, or install a custom one (takes effect on rebuild)
+*/
+		void setCurve(Curve curve)
+		{
+			requestedCurve = curve;
+			requestService();
+		}
+
+		void setCustomCurve(std::function<T(T, T)> function)
+		{
+			{
+				std::lock_guard<std::mutex> lock(customMutex);
+				custom = std::move(function);
+			}
+			requestedCurve = Curve::Custom;
+			requestService();
+		}
+/*===================================================================================*/
+/*
+	[Function] Audio thread safe: asks for a table at this alpha if it isn't the current one
+*/
+		void setAlpha(T alpha)
+		{
+			if (alpha == audioAlpha)
+				return;
+			audioAlpha = alpha;
+			requestedAlpha.store(alpha, std::memory_order_relaxed);
+			requestService();
+		}
+/*===================================================================================*/
+/*
+	[Function] buffer[i] = mix * curve(buffer[i]) over numSamples samples, in place
+*/
+		void process(T* buffer, size_t numSamples, T mix = T(1))
+		{
+			process(buffer, buffer, numSamples, mix);
+		}
+
+		void process(const T* input, T* output, size_t numSamples, T mix = T(1))
+		{
+			tables.update();
+			const Table& table = tables.read();
+			const T* values = table.values.data() + 1;
+			const T range = table.range;
+			const T scale = table.scale;
+			const T top = static_cast<T>(tableSize - 1) * (T(1) - T(1e-6));
+			if (interpolation == Interpolation::Linear)
+			{
+				for (size_t i = 0; i < numSamples; i++)
+				{
+					T x = input[i];
+					T clamped = x < -range ? -range : (x > range ? range : x);
+					T over = x - clamped;
+					T position = (clamped + range) * scale;
+					position = position > top ? top : position;
+					size_t k = static_cast<size_t>(position);
+					T fraction = position - static_cast<T>(k);
+					T y = values[k] + fraction * (values[k + 1] - values[k]);
+					if (over != T(0))
+						y = tail(table, x, over, y);
+					output[i] = mix * y;
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < numSamples; i++)
+				{
+					T x = input[i];
+					T clamped = x < -range ? -range : (x > range ? range : x);
+					T over = x - clamped;
+					T position = (clamped + range) * scale;
+					position = position > top ? top : position;
+					size_t k = static_cast<size_t>(position);
+					T f = position - static_cast<T>(k);
+					T ym1 = values[k - 1], y0 = values[k], y1 = values[k + 1], y2 = values[k + 2];
+					T y = y0 + T(0.5) * f * ((y1 - ym1) + f * ((T(2) * ym1 - T(5) * y0 + T(4) * y1 - y2) + f * (T(3) * (y0 - y1) + y2 - ym1)));
+					if (over != T(0))
+						y = tail(table, x, over, y);
+					output[i] = mix * y;
+				}
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Alpha of the table process() is currently using (audio thread)
+*/
+		T currentAlpha() const
+		{
+			return tables.read().alpha;
+		}
+/*===================================================================================*/
+/*
+	[Function] Worker thread: bakes the requested curve and publishes it
+*/
+		void service() override
+		{
+			Table& table = tables.write();
+			build(table, requestedCurve.load(), requestedAlpha.load());
+			tables.publish();
+		}
+	private:
+		struct Table
+		{
+			Curve curve = Curve::ArcTan1;
+			T alpha = T(0);
+			T range = T(1);
+			T scale = T(1);
+			T slopeLow = T(0);
+			T slopeHigh = T(0);
+			bool saturates = false;
+			T asymptoteLow = T(0);
+			T asymptoteHigh = T(0);
+			std::vector<T> values;		// one guard point before, two after
+		};
+
+		void build(Table& table, Curve curve, T alpha)
+		{
+			std::function<T(T, T)> function;
+			if (curve == Curve::Custom)
+			{
+				std::lock_guard<std::mutex> lock(customMutex);
+				function = custom;
+			}
+			const double drive = std::fabs(static_cast<double>(alpha));
+			double range = inputRange;
+			if ((curve == Curve::ArcTan1 || curve == Curve::ArcTan2) && drive > 0.0)
+				range = inputRange / drive;
+			else if (curve == Curve::ArcTanH && drive > 0.0)
+				range = 1.0 / drive;
+			else if (curve == Curve::ZeroCrossing)
+				range = std::max(range, 2.0 * drive);
+			const double step = 2.0 * range / static_cast<double>(tableSize - 1);
+			table.values.resize(tableSize + 3);
+			for (size_t k = 0; k < tableSize + 3; k++)
+			{
+				double x = -range + (static_cast<double>(k) - 1.0) * step;
+				table.values[k] = static_cast<T>(evaluate(curve, function, x, alpha));
+			}
+			table.curve = curve;
+			table.alpha = alpha;
+			table.range = static_cast<T>(range);
+			table.scale = static_cast<T>(1.0 / step);
+			table.slopeLow = static_cast<T>((table.values[2] - table.values[1]) / step);
+			table.slopeHigh = static_cast<T>((table.values[tableSize] - table.values[tableSize - 1]) / step);
+			table.saturates = curve == Curve::ArcTan1 || curve == Curve::ArcTan2 || curve == Curve::ArcTanH || curve == Curve::Custom;
+			table.asymptoteLow = table.values[1];
+			table.asymptoteHigh = table.values[tableSize];
+			if (curve == Curve::ArcTan1 || curve == Curve::ArcTan2)
+			{
+				const double limit = curve == Curve::ArcTan1 ? 0.5 * 3.14159265358979323846 : 1.0;
+				const double sign = alpha > T(0) ? 1.0 : (alpha < T(0) ? -1.0 : 0.0);
+				table.asymptoteHigh = static_cast<T>(sign * limit);
+				table.asymptoteLow = static_cast<T>(-sign * limit);
+			}
+		}
+/*===================================================================================*/
+/*
+	[Function] Curve beyond the table at x, from y, the value at the edge it passed (over is
+	x minus that edge). A saturator moves from y towards its asymptote as range / |x|; with
+	the asymptote at the edge value that is a clamp.
+*/
+		static T tail(const Table& table, T x, T over, T y)
+		{
+			if (!table.saturates)
+				return y + over * (over > T(0) ? table.slopeHigh : table.slopeLow);
+			const T asymptote = over > T(0) ? table.asymptoteHigh : table.asymptoteLow;
+			return asymptote + (y - asymptote) * (table.range / std::fabs(x));
+		}
+
+		static double evaluate(Curve curve, const std::function<T(T, T)>& function, double x, double alpha)
+		{
+			switch (curve)
+			{
+			case Curve::ArcTan1: return std::atan(alpha * x);
+			case Curve::ArcTan2: return (2.0 / 3.14159265358979323846) * std::atan(alpha * x);
+			case Curve::ArcTanH:
+			{
+				double y = alpha * x;
+				const double limit = 1.0 - 1e-6;
+				return std::atanh(y > limit ? limit : (y < -limit ? -limit : y));
+			}
+			case Curve::ZeroCrossing: return std::fabs(x) < alpha ? 0.0 : x;
+			case Curve::Halfwave: return x < 0 ? 0.0 : x;
+			case Curve::Fullwave: return std::fabs(x);
+			case Curve::Custom: return function ? static_cast<double>(function(static_cast<T>(x), static_cast<T>(alpha))) : x;
+			}
+			return x;
+		}
+
+		const size_t tableSize;
+		const T inputRange;
+		const Interpolation interpolation;
+		TripleBuffer<Table> tables;
+		std::atomic<Curve> requestedCurve{ Curve::ArcTan1 };
+		std::atomic<T> requestedAlpha{ T(1) };
+		T audioAlpha = T(1);
+		std::mutex customMutex;
+		std::function<T(T, T)> custom;
+	};
+}
+#endif
@@ -12,6 +12,11 @@
 // -----------------------------------------------------------------------------
 #include "plugincore.h"
 #include "plugindescription.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
 #pragma warning (disable : 4244)
 
 /**
@@ -59,6 +64,8 @@ PluginCore::PluginCore()
 Operation:
 - store sample rate and bit depth on audioProcDescriptor - this information is globally available to all core functions
 - reset your member objects here
+- report the kernel's latency (internal-rate resampling plus the limiter's lookahead, which
+  is in whether the Limiter switch is on or not)
 
 \param resetInfo structure of information about current audio format
 
@@ -70,6 +77,20 @@ bool PluginCore::reset(ResetInfo& resetInfo)
     audioProcDescriptor.sampleRate = resetInfo.sampleRate;
     audioProcDescriptor.bitDepth = resetInfo.bitDepth;
 
+    // --- redesign the kernel for the new rate (or the fixed internal rate) and clear its state
+    governor.reset();
+    kernel.setTier(AuxPort::Tier::Full);
+    kernel.setInternalRate(internalRate);
+    kernel.setLookahead(lookaheadMs);
+    smoothing.prepare(parameterTable, resetInfo.sampleRate, controls);
+    kernel.reset(static_cast<float>(resetInfo.sampleRate));
+    kernel.prepareToPlay(static_cast<float>(resetInfo.sampleRate));
+    designer.sync();
+    analyzer.prepare(resetInfo.sampleRate);
+
+    // --- the resampler and limiter delays depend on the rate, so the latency is set here
+    pluginDescriptor.latencyInSamples = kLatencyInSamples + static_cast<uint32_t>(kernel.getLatencySamples());
+
     // --- other reset inits
     return PluginBase::reset(resetInfo);
 }
@@ -79,11 +100,57 @@ bool PluginCore::reset(ResetInfo& resetInfo)
 
 Operation:
 - saves structure for the plugin to use; you can also load WAV files or state information here
+- picks the kernel ISAs and the kernel's sub-block size for this CPU: from the tuning cache
+  in the temp directory if this CPU model was tuned before, otherwise by timing a copy of
+  the kernel at the default parameter values and caching the result
 */
 bool PluginCore::initialize(PluginInfo& pluginInfo)
 {
 	// --- add one-time init stuff here
+	if (telemetryTarget.empty())
+	{
+		const char* target = std::getenv("AUXPORT_TELEMETRY");
+		telemetryTarget = target ? target : "";
+	}
+	telemetryExporter.start(telemetryTarget);
+	designer.start();
+	if (impulsePath.empty())
+	{
+		const char* path = std::getenv("AUXPORT_IMPULSE");
+		impulsePath = path ? path : "";
+	}
+	if (!impulsePath.empty() && cabinet.load(impulsePath))
+		kernel.loadCabinet(&cabinet);
+	kernel.loadAnalyzer(&analyzer);
+
+	if (!autoTune)
+		return true;
 
+	// --- tuning is per process: the first instance loads (or measures) it, the rest reuse it
+	static std::once_flag tuned;
+	static AuxPort::TuneResult tuning;
+	std::call_once(tuned, [this]()
+	{
+		std::error_code error;
+		std::string directory = std::filesystem::temp_directory_path(error).string();
+		std::string cachePath = AuxPort::AutoTuner::cachePath(error ? std::string(".") : directory);
+		if (!AuxPort::AutoTuner::load(cachePath, tuning))
+		{
+			AuxPort::ProductionEffect probe = kernel;
+			probe.loadCabinet(nullptr);
+			probe.loadAnalyzer(nullptr);
+			probe.reset(44100.0f);
+			probe.prepareToPlay(44100.0f);
+			tuning = AuxPort::AutoTuner::tune([&probe](float* left, float* right, size_t numSamples, size_t subBlockSize)
+			{
+				probe.setSubBlockSize(subBlockSize);
+				probe.run(left, right, numSamples);
+			});
+			AuxPort::AutoTuner::save(cachePath, tuning);
+		}
+		AuxPort::AutoTuner::apply(tuning);
+	});
+	kernel.setSubBlockSize(tuning.subBlockSize);
 	return true;
 }
 
@@ -96,6 +163,8 @@ Operation:
 - NOTE: postUpdatePluginParameter( ) will be called for all bound variables that are acutally updated; if you need to process
   them individually, do so in that function
 - use this function to bulk-transfer the bound variable data into your plugin's member object variables
+- hand changed filter settings to the designer and install finished designs
+- start timing this callback (telemetry and load governor)
 
 \param processInfo structure of information about *buffer* processing
 
@@ -107,6 +176,16 @@ bool PluginCore::preProcessAudioBuffers(ProcessBufferInfo& processInfo)
     //     want to use the auto-variable-binding
     syncInBoundVariables();
 
+    // --- the new values are where the smoothers head; the ramps advance per sub-block
+    smoothing.retarget(controls);
+
+    // --- install filter designs finished since the last buffer and request new ones if
+    //     the controls moved (the design itself runs on the worker thread)
+    designer.update();
+
+    // --- the callback is timed from here to the end of postProcessAudioBuffers
+    telemetry.begin();
+
     return true;
 }
 
@@ -143,7 +222,7 @@ bool PluginCore::preProcessAudioBuffers(ProcessBufferInfo& processInfo)
 Operation:
 - decode the plugin type - for synth plugins, fill in the rendering code; for FX plugins, delete the if(synth) portion and add your processing code
 - note that MIDI events are fired for each sample interval so that MIDI is tightly sunk with audio
-- doSampleAccurateParameterUpdates will perform per-sample interval smoothing
+- parameter smoothing is advanced every frame, so ramps stay as fine as ASPiK's own
 
 \param processFrameInfo structure of information about *frame* processing
 
@@ -154,8 +233,8 @@ bool PluginCore::processAudioFrame(ProcessFrameInfo& processFrameInfo)
     // --- fire any MIDI events for this sample interval
     processFrameInfo.midiEventQueue->fireMidiEvents(processFrameInfo.currentFrame);
 
-	// --- do per-frame smoothing
-	doParameterSmoothing();
+	// --- do per-frame smoothing (only a flag check once every ramp has settled)
+	smoothing.advance(1);
 
 	// --- call your GUI update/cooking function here, now that smoothing has occurred
 	//
@@ -166,6 +245,15 @@ bool PluginCore::processAudioFrame(ProcessFrameInfo& processFrameInfo)
 	// updateParameters();
 	
 
+	// --- the sidechain frame, if the host connected one (drives the filter modulation)
+	AuxPort::Frame<float> sidechainFrame{ 0.0f, 0.0f };
+	const bool sidechained = processFrameInfo.numAuxAudioInChannels > 0 && processFrameInfo.auxAudioInputFrame;
+	if (sidechained)
+	{
+		sidechainFrame.left = processFrameInfo.auxAudioInputFrame[0];
+		sidechainFrame.right = processFrameInfo.numAuxAudioInChannels > 1 ? processFrameInfo.auxAudioInputFrame[1] : sidechainFrame.left;
+	}
+
     // --- decode the channelIOConfiguration and process accordingly
     //
 	// --- Synth Plugin:
@@ -187,7 +275,10 @@ bool PluginCore::processAudioFrame(ProcessFrameInfo& processFrameInfo)
 		// --- pass through code: change this with your signal processing
 		audioFrame.left = processFrameInfo.audioInputFrame[0];
 		audioFrame.right = processFrameInfo.audioInputFrame[0];
-		kernel.run(audioFrame);
+		if (sidechained)
+			kernel.run(audioFrame, sidechainFrame);
+		else
+			kernel.run(audioFrame);
 		processFrameInfo.audioOutputFrame[0] = audioFrame.left;
 
         return true; /// processed
@@ -200,7 +291,10 @@ bool PluginCore::processAudioFrame(ProcessFrameInfo& processFrameInfo)
 		// --- pass through code: change this with your signal processing
 		audioFrame.left = processFrameInfo.audioInputFrame[0];
 		audioFrame.right = processFrameInfo.audioInputFrame[0];
-		kernel.run(audioFrame);
+		if (sidechained)
+			kernel.run(audioFrame, sidechainFrame);
+		else
+			kernel.run(audioFrame);
         processFrameInfo.audioOutputFrame[0] = audioFrame.left;
         processFrameInfo.audioOutputFrame[1] = audioFrame.right;
 
@@ -214,7 +308,10 @@ bool PluginCore::processAudioFrame(ProcessFrameInfo& processFrameInfo)
 		// --- pass through code: change this with your signal processing
 		audioFrame.left = processFrameInfo.audioInputFrame[0];
 		audioFrame.right = processFrameInfo.audioInputFrame[1];
-		kernel.run(audioFrame);
+		if (sidechained)
+			kernel.run(audioFrame, sidechainFrame);
+		else
+			kernel.run(audioFrame);
         processFrameInfo.audioOutputFrame[0] = audioFrame.left;
         processFrameInfo.audioOutputFrame[1] = audioFrame.right;
 
@@ -256,13 +353,7 @@ bool PluginCore::preProcessAudioBlock(IMidiEventQueue* midiEventQueue)
 			midiEventQueue->fireMidiEvents(sample);
 	}
 
-	// --- this will do parameter smoothing ONLY ONCE AT THE TOP OF THE BLOCK PROCESSING
-	//
-	// --- to perform per-sample parameter smoothing, move this line of code, AND your updating
-	//     functions (see updateParameters( ) in comment below) into the for( ) loop above
-	//     NOTE: smoothing only once per block usually SAVES CPU cycles
-	//           smoothing once per sample period usually EATS CPU cycles, potentially unnecessarily
-	doParameterSmoothing();
+	// --- parameter smoothing is done by the SmoothingEngine, per sub-block in renderFX( )
 
 	// --- call your GUI update/cooking function here, now that smoothing has occurred
 	//
@@ -332,7 +423,7 @@ bool PluginCore::processAudioBlock(ProcessBlockInfo& processBlockInfo)
 
 	// --- or FX
 	else if (getPluginType() == kFXPlugin)
-		renderFXPassThrough(processBlockInfo);
+		renderFX(processBlockInfo);
 
 	return true;
 }
@@ -408,11 +499,55 @@ bool PluginCore::renderFXPassThrough(ProcessBlockInfo& blockInfo)
 }
 
 
+/**
+\brief
+Renders the block through the AuxPort kernel
+
+Operation:
+- run the kernel's block path from the input buffers straight into the output buffers
+  (mono inputs feed both kernel inputs; in-place hosts pass aliased buffers, which is fine)
+- hand it the sidechain buffers, if the host connected any (they drive the filter modulation)
+- advance the parameter smoothers once per sub-block while any of them is ramping (the
+  kernel ramps its gains across each sub-block to the new values)
+
+\param blockInfo structure of information about *block* processing
+\return true if operation succeeds, false otherwise
+*/
+bool PluginCore::renderFX(ProcessBlockInfo& blockInfo)
+{
+	if (blockInfo.numAudioOutChannels == 0 || blockInfo.numAudioInChannels == 0)
+		return false;
+
+	const uint32_t start = blockInfo.blockStartIndex;
+	const uint32_t size = blockInfo.blockSize;
+	const float* inputLeft = blockInfo.inputs[0] + start;
+	const float* inputRight = blockInfo.numAudioInChannels > 1 ? blockInfo.inputs[1] + start : inputLeft;
+	float* left = blockInfo.outputs[0] + start;
+	float* right = blockInfo.numAudioOutChannels > 1 ? blockInfo.outputs[1] + start : nullptr;
+	const bool sidechained = blockInfo.numAuxAudioInChannels > 0 && blockInfo.auxAudioInBuffers;
+	const float* sidechainLeft = sidechained ? blockInfo.auxAudioInBuffers[0] + start : nullptr;
+	const float* sidechainRight = sidechained && blockInfo.numAuxAudioInChannels > 1 ? blockInfo.auxAudioInBuffers[1] + start : nullptr;
+
+	// --- while a parameter ramps, the block goes through the kernel a sub-block at a time
+	//     with the smoothers advanced before each; settled parameters cost nothing
+	const uint32_t chunk = static_cast<uint32_t>(kernel.getSubBlockSize());
+	for (uint32_t done = 0; done < size;)
+	{
+		const uint32_t n = smoothing.isMoving() ? std::min(chunk, size - done) : size - done;
+		smoothing.advance(n);
+		kernel.run(inputLeft + done, inputRight + done, left + done, right ? right + done : nullptr, n,
+			sidechainLeft ? sidechainLeft + done : nullptr, sidechainRight ? sidechainRight + done : nullptr);
+		done += n;
+	}
+	return true;
+}
+
 /**
 \brief do anything needed prior to arrival of audio buffers
 
 Operation:
 - updateOutBoundVariables sends metering data to the GUI meters
+- record the callback's timing, feed its load to the governor and apply any tier change
 
 \param processInfo structure of information about *buffer* processing
 
@@ -424,6 +559,12 @@ bool PluginCore::postProcessAudioBuffers(ProcessBufferInfo& processInfo)
 	//     in the future
 	updateOutBoundVariables();
 
+	// --- charge this callback against its deadline; a tier change crossfades inside the kernel
+	const double load = telemetry.end(processInfo.numFramesToProcess, audioProcDescriptor.sampleRate);
+	telemetryExporter.tick(processInfo.numFramesToProcess, audioProcDescriptor.sampleRate);
+	if (processInfo.numFramesToProcess > 0 && governor.update(load))
+		kernel.setTier(governor.getTier());
+
     return true;
 }
 
@@ -471,7 +612,6 @@ bool PluginCore::updatePluginParameterNormalized(int32_t controlID, double norma
 
 	// --- do any post-processing
 	postUpdatePluginParameter(controlID, controlValue, paramInfo);
-	kernel.prepareToPlay(audioProcDescriptor.sampleRate);
 	return true; /// handled
 }
 
@@ -561,25 +701,40 @@ bool PluginCore::processMessage(MessageInfo& messageInfo)
 		// --- add customization appearance here
 	case PLUGINGUI_DIDOPEN:
 	{
+		// --- the analyzer only runs (and the audio thread only feeds it) while the GUI is open
+		analyzer.start();
 		return false;
 	}
 
 	// --- NULL pointers so that we don't accidentally use them
 	case PLUGINGUI_WILLCLOSE:
 	{
+		spectrumView = nullptr;
+		analyzer.stop();
 		return false;
 	}
 
 	// --- update view; this will only be called if the GUI is actually open
 	case PLUGINGUI_TIMERPING:
 	{
-		return false;
+		// --- the newest analyzer frame, if one was published since the last ping
+		if (spectrumView && analyzer.update())
+		{
+			spectrumView->sendMessage(const_cast<AuxPort::SpectrumFrame*>(&analyzer.read()));
+			spectrumView->updateView();
+		}
+		return spectrumView != nullptr;
 	}
 
 	// --- register the custom view, grab the ICustomView interface
 	case PLUGINGUI_REGISTER_CUSTOMVIEW:
 	{
-
+		// --- the view receives an AuxPort::SpectrumFrame* through sendMessage( )
+		if (messageInfo.inMessageString.compare("SpectrumView") == 0)
+		{
+			spectrumView = static_cast<ICustomView*>(messageInfo.inMessageData);
+			return spectrumView != nullptr;
+		}
 		return false;
 	}
 
@@ -659,220 +814,33 @@ bool PluginCore::initPluginParameters()
 	// **--0xDEA7--**
 
 
-	// --- Declaration of Plugin Parameter Objects 
-	PluginParameter* piParam = nullptr;
-
-	// --- continuous control: PreGain
-	piParam = new PluginParameter(controlID::preGain, "PreGain", "Units", controlVariableType::kFloat, 0.000000, 2.000000, 0.000000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&preGain, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: LPF_FC
-	piParam = new PluginParameter(controlID::lowPassFC, "LPF_FC", "Units", controlVariableType::kFloat, 20.000000, 10000.000000, 100.000000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&lowPassFC, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: LPF_Q
-	piParam = new PluginParameter(controlID::lowPass_Q, "LPF_Q", "Units", controlVariableType::kFloat, 0.500000, 10.000000, 2.000000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&lowPass_Q, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: HPF_FC
-	piParam = new PluginParameter(controlID::highPassFC, "HPF_FC", "Units", controlVariableType::kFloat, 20.000000, 20000.000000, 100.000000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&highPassFC, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: HPF_Q
-	piParam = new PluginParameter(controlID::highPassQ, "HPF_Q", "Units", controlVariableType::kFloat, 0.500000, 10.000000, 2.000000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&highPassQ, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: A1_Mix
-	piParam = new PluginParameter(controlID::A1, "A1_Mix", "Units", controlVariableType::kFloat, 0.000000, 1.000000, 0.500000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&A1, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: A2_Mix
-	piParam = new PluginParameter(controlID::A2, "A2_Mix", "Units", controlVariableType::kFloat, 0.000000, 1.000000, 0.500000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&A2, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: LPF_Boost
-	piParam = new PluginParameter(controlID::lpfBoost, "LPF_Boost", "Units", controlVariableType::kFloat, 0.000000, 1.000000, 0.707000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&lpfBoost, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: HPF_Boost
-	piParam = new PluginParameter(controlID::hpfBoost, "HPF_Boost", "Units", controlVariableType::kFloat, 0.000000, 1.000000, 0.707000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&hpfBoost, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- discrete control: FullWaveSwitch
-	piParam = new PluginParameter(controlID::fullWaveSwitch, "FullWaveSwitch", "SWITCH OFF,SWITCH ON", "SWITCH OFF");
-	piParam->setBoundVariable(&fullWaveSwitch, boundVariableType::kInt);
-	piParam->setIsDiscreteSwitch(true);
-	addPluginParameter(piParam);
-
-	// --- continuous control: BPF_FC
-	piParam = new PluginParameter(controlID::bandPassFC, "BPF_FC", "Units", controlVariableType::kFloat, 20.000000, 10000.000000, 100.000000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&bandPassFC, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: BPF_Q
-	piParam = new PluginParameter(controlID::bandPassQ, "BPF_Q", "Units", controlVariableType::kFloat, 0.500000, 10.000000, 2.000000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&bandPassQ, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: BPF_Boost
-	piParam = new PluginParameter(controlID::bandPassBoost, "BPF_Boost", "Units", controlVariableType::kFloat, 0.000000, 1.000000, 0.707000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&bandPassBoost, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: MasterDistortion
-	piParam = new PluginParameter(controlID::masterD, "MasterDistortion", "Units", controlVariableType::kFloat, 0.000000, 1.000000, 0.500000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&masterD, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- continuous control: MasterClean
-	piParam = new PluginParameter(controlID::masterC, "MasterClean", "Units", controlVariableType::kFloat, 0.000000, 1.000000, 0.500000, taper::kLinearTaper);
-	piParam->setParameterSmoothing(true);
-	piParam->setSmoothingTimeMsec(20.00);
-	piParam->setBoundVariable(&masterC, boundVariableType::kFloat);
-	addPluginParameter(piParam);
-
-	// --- Aux Attributes
-	AuxParameterAttribute auxAttribute;
-
-	// --- RAFX GUI attributes
-	// --- controlID::preGain
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483651);
-	setParamAuxAttribute(controlID::preGain, auxAttribute);
-
-	// --- controlID::lowPassFC
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483673);
-	setParamAuxAttribute(controlID::lowPassFC, auxAttribute);
-
-	// --- controlID::lowPass_Q
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483660);
-	setParamAuxAttribute(controlID::lowPass_Q, auxAttribute);
-
-	// --- controlID::highPassFC
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483673);
-	setParamAuxAttribute(controlID::highPassFC, auxAttribute);
-
-	// --- controlID::highPassQ
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483660);
-	setParamAuxAttribute(controlID::highPassQ, auxAttribute);
-
-	// --- controlID::A1
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483651);
-	setParamAuxAttribute(controlID::A1, auxAttribute);
-
-	// --- controlID::A2
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483651);
-	setParamAuxAttribute(controlID::A2, auxAttribute);
-
-	// --- controlID::lpfBoost
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483676);
-	setParamAuxAttribute(controlID::lpfBoost, auxAttribute);
-
-	// --- controlID::hpfBoost
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483676);
-	setParamAuxAttribute(controlID::hpfBoost, auxAttribute);
-
-	// --- controlID::fullWaveSwitch
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(1073741824);
-	setParamAuxAttribute(controlID::fullWaveSwitch, auxAttribute);
-
-	// --- controlID::bandPassFC
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483673);
-	setParamAuxAttribute(controlID::bandPassFC, auxAttribute);
-
-	// --- controlID::bandPassQ
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483660);
-	setParamAuxAttribute(controlID::bandPassQ, auxAttribute);
-
-	// --- controlID::bandPassBoost
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483676);
-	setParamAuxAttribute(controlID::bandPassBoost, auxAttribute);
-
-	// --- controlID::masterD
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483718);
-	setParamAuxAttribute(controlID::masterD, auxAttribute);
-
-	// --- controlID::masterC
-	auxAttribute.reset(auxGUIIdentifier::guiControlData);
-	auxAttribute.setUintAttribute(2147483718);
-	setParamAuxAttribute(controlID::masterC, auxAttribute);
-
-
 	// **--0xEDA5--**
-	kernel.push(&preGain, boundVariableType::kFloat, controlID::preGain);
-
-	kernel.push(&lowPassFC, boundVariableType::kFloat, controlID::lowPassFC);
-	kernel.push(&lowPass_Q, boundVariableType::kFloat, controlID::lowPass_Q);
-	kernel.push(&lpfBoost, boundVariableType::kFloat, controlID::lpfBoost);
-
-	kernel.push(&highPassFC, boundVariableType::kFloat, controlID::highPassFC);
-	kernel.push(&highPassQ, boundVariableType::kFloat, controlID::highPassQ);
-	kernel.push(&hpfBoost, boundVariableType::kFloat, controlID::hpfBoost);
-
-	kernel.push(&bandPassFC, boundVariableType::kFloat, controlID::bandPassFC);
-	kernel.push(&bandPassQ, boundVariableType::kFloat, controlID::bandPassQ);
-	kernel.push(&bandPassBoost, boundVariableType::kFloat, controlID::bandPassBoost);
-
-	
-	kernel.push(&fullWaveSwitch, boundVariableType::kInt, controlID::fullWaveSwitch);
-	
-	kernel.push(&A1, boundVariableType::kFloat, controlID::A1);
-	kernel.push(&A2, boundVariableType::kFloat, controlID::A2);
 
-	kernel.push(&masterC, boundVariableType::kFloat, controlID::masterC);
-	kernel.push(&masterD, boundVariableType::kFloat, controlID::masterD);
-	
-	
+	// --- Plugin Parameter Objects, built from the shared parameterTable and bound to this
+	//     instance's contiguous controls block (outside the hex codes, which ASPiKreator
+	//     and RackAFX regenerate; new parameters go in parameterDescriptors)
+	AuxParameterAttribute auxAttribute;
+	for (size_t slot = 0; slot < parameterTable.size(); slot++)
+	{
+		const AuxPort::ParameterDescriptor& descriptor = parameterTable[slot];
+		PluginParameter* piParam = nullptr;
+		if (descriptor.type == controlVariableType::kTypedEnumStringList)
+			piParam = new PluginParameter(descriptor.id, descriptor.name, descriptor.units, descriptor.defaultString);
+		else
+			piParam = new PluginParameter(descriptor.id, descriptor.name, descriptor.units, descriptor.type, descriptor.minimum, descriptor.maximum, descriptor.defaultValue, descriptor.curve);
+		piParam->setIsDiscreteSwitch(descriptor.discreteSwitch);
+		piParam->setBoundVariable(&controls[slot], boundVariableType::kFloat);
+		addPluginParameter(piParam);
+
+		// --- RAFX GUI attributes
+		auxAttribute.reset(auxGUIIdentifier::guiControlData);
+		auxAttribute.setUintAttribute(descriptor.guiControlData);
+		setParamAuxAttribute(descriptor.id, auxAttribute);
+	}
 
-	
+	parameterTable.setDefaults(controls);
+	smoothing.prepare(parameterTable, audioProcDescriptor.sampleRate, controls);
+	kernel.bind({ smoothing.values(), parameterTable.slotMap() });
 
 	// --- BONUS Parameter
 	// --- SCALE_GUI_SIZE
@@ -921,6 +889,14 @@ bool PluginCore::initPluginPresets()
 	setPresetParameter(preset->presetParameters, controlID::bandPassBoost, 0.707000);
 	setPresetParameter(preset->presetParameters, controlID::masterD, 0.000000);
 	setPresetParameter(preset->presetParameters, controlID::masterC, 0.000000);
+	setPresetParameter(preset->presetParameters, controlID::sidechainCutoff, 0.000000);
+	setPresetParameter(preset->presetParameters, controlID::sidechainDuck, 0.000000);
+	setPresetParameter(preset->presetParameters, controlID::sidechainAttack, 5.000000);
+	setPresetParameter(preset->presetParameters, controlID::sidechainRelease, 150.000000);
+	setPresetParameter(preset->presetParameters, controlID::crossoverMode, -0.000000);
+	setPresetParameter(preset->presetParameters, controlID::limiterSwitch, -0.000000);
+	setPresetParameter(preset->presetParameters, controlID::limiterCeiling, -0.300000);
+	setPresetParameter(preset->presetParameters, controlID::limiterRelease, 100.000000);
 	addPreset(preset);
 
 
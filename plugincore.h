@@ -14,7 +14,11 @@
 #define __pluginCore_h__
 
 #include "pluginbase.h"
-#include "AudioEffect.h"
+#include "Telemetry.h"
+#include "FilterDesigner.h"
+#include "Smoothing.h"
+#include "Convolver.h"
+#include "Analyzer.h"
 
 // **--0x7F1F--**
 
@@ -35,11 +39,52 @@ enum controlID {
 	bandPassQ = 26,
 	bandPassBoost = 27,
 	masterD = 69,
-	masterC = 79
+	masterC = 79,
+	sidechainCutoff = 50,
+	sidechainDuck = 51,
+	sidechainAttack = 52,
+	sidechainRelease = 53,
+	crossoverMode = 54,
+	limiterSwitch = 55,
+	limiterCeiling = 56,
+	limiterRelease = 57
 };
 
 	// **--0x0F1F--**
 
+// --- the kernel reads the controlIDs above, so it comes after them (MSVC let it see them
+//     late; gcc and clang need them declared first)
+#include "AudioEffect.h"
+
+// --- Parameter metadata, shared read-only by every instance; the order is the slot order
+//     of PluginCore::controls (and the order the parameters are created in)
+inline constexpr AuxPort::ParameterDescriptor parameterDescriptors[] = {
+	{ controlID::preGain, "PreGain", "Units", controlVariableType::kFloat, 0.0, 2.0, 0.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483651u },
+	{ controlID::lowPassFC, "LPF_FC", "Units", controlVariableType::kFloat, 20.0, 10000.0, 100.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483673u },
+	{ controlID::lowPass_Q, "LPF_Q", "Units", controlVariableType::kFloat, 0.5, 10.0, 2.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483660u },
+	{ controlID::highPassFC, "HPF_FC", "Units", controlVariableType::kFloat, 20.0, 20000.0, 100.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483673u },
+	{ controlID::highPassQ, "HPF_Q", "Units", controlVariableType::kFloat, 0.5, 10.0, 2.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483660u },
+	{ controlID::A1, "A1_Mix", "Units", controlVariableType::kFloat, 0.0, 1.0, 0.5, taper::kLinearTaper, 20.0, nullptr, false, 2147483651u },
+	{ controlID::A2, "A2_Mix", "Units", controlVariableType::kFloat, 0.0, 1.0, 0.5, taper::kLinearTaper, 20.0, nullptr, false, 2147483651u },
+	{ controlID::lpfBoost, "LPF_Boost", "Units", controlVariableType::kFloat, 0.0, 1.0, 0.707, taper::kLinearTaper, 20.0, nullptr, false, 2147483676u },
+	{ controlID::hpfBoost, "HPF_Boost", "Units", controlVariableType::kFloat, 0.0, 1.0, 0.707, taper::kLinearTaper, 20.0, nullptr, false, 2147483676u },
+	{ controlID::fullWaveSwitch, "FullWaveSwitch", "SWITCH OFF,SWITCH ON", controlVariableType::kTypedEnumStringList, 0.0, 1.0, 0.0, taper::kLinearTaper, 0.0, "SWITCH OFF", true, 1073741824u },
+	{ controlID::bandPassFC, "BPF_FC", "Units", controlVariableType::kFloat, 20.0, 10000.0, 100.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483673u },
+	{ controlID::bandPassQ, "BPF_Q", "Units", controlVariableType::kFloat, 0.5, 10.0, 2.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483660u },
+	{ controlID::bandPassBoost, "BPF_Boost", "Units", controlVariableType::kFloat, 0.0, 1.0, 0.707, taper::kLinearTaper, 20.0, nullptr, false, 2147483676u },
+	{ controlID::masterD, "MasterDistortion", "Units", controlVariableType::kFloat, 0.0, 1.0, 0.5, taper::kLinearTaper, 20.0, nullptr, false, 2147483718u },
+	{ controlID::masterC, "MasterClean", "Units", controlVariableType::kFloat, 0.0, 1.0, 0.5, taper::kLinearTaper, 20.0, nullptr, false, 2147483718u },
+	{ controlID::sidechainCutoff, "SC_Cutoff", "Octaves", controlVariableType::kFloat, -4.0, 4.0, 0.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483651u },
+	{ controlID::sidechainDuck, "SC_Duck", "Units", controlVariableType::kFloat, 0.0, 1.0, 0.0, taper::kLinearTaper, 20.0, nullptr, false, 2147483651u },
+	{ controlID::sidechainAttack, "SC_Attack", "mSec", controlVariableType::kFloat, 0.1, 200.0, 5.0, taper::kLogTaper, 0.0, nullptr, false, 2147483651u },
+	{ controlID::sidechainRelease, "SC_Release", "mSec", controlVariableType::kFloat, 5.0, 2000.0, 150.0, taper::kLogTaper, 0.0, nullptr, false, 2147483651u },
+	{ controlID::crossoverMode, "Crossover", "OFF,LR2,LR4", controlVariableType::kTypedEnumStringList, 0.0, 2.0, 0.0, taper::kLinearTaper, 0.0, "OFF", true, 1073741824u },
+	{ controlID::limiterSwitch, "Limiter", "OFF,ON", controlVariableType::kTypedEnumStringList, 0.0, 1.0, 0.0, taper::kLinearTaper, 0.0, "OFF", true, 1073741824u },
+	{ controlID::limiterCeiling, "Limit_Ceiling", "dB", controlVariableType::kFloat, -24.0, 0.0, -0.3, taper::kLinearTaper, 20.0, nullptr, false, 2147483651u },
+	{ controlID::limiterRelease, "Limit_Release", "mSec", controlVariableType::kFloat, 10.0, 1000.0, 100.0, taper::kLogTaper, 0.0, nullptr, false, 2147483651u }
+};
+inline constexpr AuxPort::ParameterTable<sizeof(parameterDescriptors) / sizeof(parameterDescriptors[0])> parameterTable(parameterDescriptors);
+
 /**
 \class PluginCore
 \ingroup ASPiK-Core
@@ -127,6 +172,9 @@ public:
 	/** FX EXAMPLE: process audio by passing through */
 	bool renderFXPassThrough(ProcessBlockInfo& blockInfo);
 
+	/** FX: process audio through the AuxPort kernel's block path */
+	bool renderFX(ProcessBlockInfo& blockInfo);
+
 	/** SYNTH EXAMPLE: render a block of silence */
 	bool renderSynthSilence(ProcessBlockInfo& blockInfo);
 
@@ -142,30 +190,53 @@ protected:
 private:
 	//  **--0x07FD--**
 
-	// --- Continuous Plugin Variables 
-	float preGain = 0.f;
-	float lowPassFC = 0.f;
-	float lowPass_Q = 0.f;
-	float highPassFC = 0.f;
-	float highPassQ = 0.f;
-	float A1 = 0.f;
-	float A2 = 0.f;
-	float lpfBoost = 0.f;
-	float hpfBoost = 0.f;
-	float bandPassFC = 0.f;
-	float bandPassQ = 0.f;
-	float bandPassBoost = 0.f;
-	float masterD = 0.f;
-	float masterC = 0.f;
-
-	// --- Discrete Plugin Variables 
-	int fullWaveSwitch = 0;
-	enum class fullWaveSwitchEnum { SWITCH_OFF,SWITCH_ON };	// to compare: if(compareEnumToInt(fullWaveSwitchEnum::SWITCH_OFF, fullWaveSwitch)) etc... 
+	// --- Plugin variables, one float per parameterTable slot in one contiguous block; the
+	//     discrete switch is bound as a float too (its value is the list index)
+	float controls[parameterTable.size()] = {};
+
+	// --- smooths the controls for the kernel once per sub-block in renderFX( ) and once per
+	//     frame in processAudioFrame( ) (ASPiK's per-parameter smoothing is off); the kernel
+	//     reads smoothing.values(), the host writes controls
+	AuxPort::SmoothingEngine<parameterTable.size()> smoothing;
 
 	// **--0x1A7F--**
     // --- end member variables
-	AuxPort::Effect<float, float> kernel;
+	AuxPort::ProductionEffect kernel;
 	AuxPort::Frame<float> audioFrame;
+
+	// --- designs the kernel's filters on the worker thread; new coefficients are picked
+	//     up at the top of each buffer
+	AuxPort::FilterDesigner<AuxPort::ProductionEffect> designer{ kernel };
+
+	// --- time the dispatched kernels and sub-block sizes at initialize() (cached per CPU model)
+	bool autoTune = true;
+
+	// --- run the kernel at this fixed rate with resampling at the edges (0 = host rate)
+	double internalRate = 0.0;
+
+	// --- lookahead of the output limiter (0 = no limiter). Its delay is always in and
+	//     reported as latency; the Limiter switch only bypasses the gain, so it can be
+	//     flipped mid-session without the latency changing
+	double lookaheadMs = 1.0;
+
+	// --- steps the kernel down to cheaper tiers when a callback nears its real-time budget
+	AuxPort::LoadGovernor governor;
+
+	// --- per-callback timing, exported to a file or "unix:<socket path>" (empty = the
+	//     AUXPORT_TELEMETRY environment variable, unset = no export)
+	AuxPort::CallbackTelemetry telemetry;
+	std::string telemetryTarget;
+	AuxPort::TelemetryExporter telemetryExporter{ telemetry, &governor };
+
+	// --- cabinet / impulse response after the final mix, from a WAV file (empty = the
+	//     AUXPORT_IMPULSE environment variable, unset = no cabinet)
+	AuxPort::Convolver<float> cabinet;
+	std::string impulsePath;
+
+	// --- input / output spectrum, analyzed on the worker thread while the GUI is open and
+	//     handed to the "SpectrumView" custom view on the GUI timer
+	AuxPort::SpectrumAnalyzer analyzer;
+	ICustomView* spectrumView = nullptr;
 public:
     /** static description: bundle folder name
 
@@ -0,0 +1,105 @@
+/*
+*			AuxPort Convolver test
+			Convolves noise with a response long enough to have a tail section, in uneven block
+			sizes, and checks the output against direct convolution: inline, on the worker at
+			full speed (a faster than real time bounce, where tail blocks come late) and on the
+			worker with pauses, where it mostly keeps up. The worker modes must match inline bit
+			for bit.
+			See LICENSE in the repository root.
+*/
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Convolver.h"
+using namespace AuxPort;
+
+enum class Mode { inlineTail, bounce, paced };
+
+/*===================================================================================*/
+/*
+	[Function] Runs input through a Convolver with response in the given mode
+*/
+template<class T>
+static std::vector<T> convolve(const std::vector<T>& response, const std::vector<T>& input, Mode mode, uint64_t& late)
+{
+	Convolver<T> convolver;
+	convolver.setImpulse(response.data(), response.size(), 48000.0);
+	convolver.setBackground(mode != Mode::inlineTail);
+	convolver.prepare(48000.0);
+
+	std::vector<T> output(input);
+	static const size_t blocks[] = { 1, 13, 64, 100, 512, 2048, 4000 };
+	size_t b = 0, sinceBreak = 0;
+	for (size_t start = 0; start < output.size(); b++)
+	{
+		const size_t count = std::min(blocks[b % 7], output.size() - start);
+		convolver.process(output.data() + start, count);
+		start += count;
+		sinceBreak += count;
+		// a pause for the worker after every tail block's worth of input
+		if (mode == Mode::paced && sinceBreak >= Convolver<T>::tailSize)
+		{
+			sinceBreak = 0;
+			BackgroundWorker::get().wake();
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+	}
+	late = convolver.getLateBlocks();
+	return output;
+}
+
+template<class T>
+static bool run(const char* type, double bound)
+{
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<double> noise(-1.0, 1.0);
+	std::vector<T> response(3 * Convolver<T>::tailSize + 777);
+	for (size_t k = 0; k < response.size(); k++)
+		response[k] = static_cast<T>(noise(random) * std::exp(-3.0 * static_cast<double>(k) / static_cast<double>(response.size())));
+	std::vector<T> input(12 * Convolver<T>::tailSize + 321);
+	for (T& x : input)
+		x = static_cast<T>(noise(random));
+
+	double peak = 0.0;
+	std::vector<double> direct(input.size(), 0.0);
+	for (size_t n = 0; n < input.size(); n++)
+	{
+		double sum = 0.0;
+		for (size_t k = 0; k < response.size() && k <= n; k++)
+			sum += static_cast<double>(response[k]) * static_cast<double>(input[n - k]);
+		direct[n] = sum;
+		peak = std::max(peak, std::fabs(sum));
+	}
+
+	uint64_t late = 0;
+	const std::vector<T> reference = convolve(response, input, Mode::inlineTail, late);
+	double error = 0.0;
+	for (size_t n = 0; n < input.size(); n++)
+		error = std::max(error, std::fabs(static_cast<double>(reference[n]) - direct[n]));
+	bool ok = error <= bound * peak;
+	std::printf("%s inline: max error %.3g of peak %.3g %s\n", type, error, peak, ok ? "ok" : "FAILED");
+
+	static const Mode modes[] = { Mode::bounce, Mode::paced };
+	static const char* names[] = { "bounce", "paced" };
+	for (int m = 0; m < 2; m++)
+	{
+		const std::vector<T> output = convolve(response, input, modes[m], late);
+		size_t differ = 0;
+		for (size_t n = 0; n < input.size(); n++)
+			differ += output[n] != reference[n];
+		std::printf("%s %s: %zu samples differ from inline, %llu late blocks %s\n", type, names[m], differ,
+			static_cast<unsigned long long>(late), differ == 0 ? "ok" : "FAILED");
+		ok = ok && differ == 0;
+	}
+	return ok;
+}
+
+int main()
+{
+	bool ok = run<double>("double", 1e-12);
+	ok = run<float>("float", 1e-5) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/*
+*			AuxPort FastMath test
+			Checks every accuracy tier of FastMath's atan and atanh against libm (in double)
+			over the full input range, against the max errors documented in FastMath.h.
+			See LICENSE in the repository root.
+*/
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "FastMath.h"
+using namespace AuxPort;
+
+/*===================================================================================*/
+/*
+	[Struct] Documented max absolute error of one function for one type, per tier
+*/
+struct Bounds
+{
+	const char* name;
+	double low, medium, high;
+};
+
+/*===================================================================================*/
+/*
+	[Function] Sweeps float bit patterns (every stride-th, all signs and exponents) whose
+	value passes accept(), and checks each tier of fast<T> against exact() in double
+*/
+template<class T, class Fast, class Exact, class Accept>
+static bool sweep(const Bounds& bounds, const char* type, uint32_t stride, Fast fast, Exact exact, Accept accept)
+{
+	double worst[3] = { 0.0, 0.0, 0.0 };
+	double worstAt[3] = { 0.0, 0.0, 0.0 };
+	for (uint64_t pattern = 0; pattern <= 0xFFFFFFFFull; pattern += stride)
+	{
+		const uint32_t bits = static_cast<uint32_t>(pattern);
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		if (!std::isfinite(value) || !accept(value))
+			continue;
+		const T x = static_cast<T>(value);
+		const double reference = exact(static_cast<double>(value));
+		const double error[3] = {
+			std::fabs(static_cast<double>(fast(x, Accuracy::Low)) - reference),
+			std::fabs(static_cast<double>(fast(x, Accuracy::Medium)) - reference),
+			std::fabs(static_cast<double>(fast(x, Accuracy::High)) - reference)
+		};
+		for (int tier = 0; tier < 3; tier++)
+		{
+			if (error[tier] > worst[tier])
+			{
+				worst[tier] = error[tier];
+				worstAt[tier] = static_cast<double>(value);
+			}
+		}
+	}
+	const double bound[3] = { bounds.low, bounds.medium, bounds.high };
+	const char* tierName[3] = { "Low", "Medium", "High" };
+	bool passed = true;
+	for (int tier = 0; tier < 3; tier++)
+	{
+		const bool ok = worst[tier] <= bound[tier];
+		passed = passed && ok;
+		std::printf("%-6s %-6s %-6s max error %.3g at %.9g (bound %.3g) %s\n", bounds.name, type, tierName[tier], worst[tier], worstAt[tier], bound[tier], ok ? "ok" : "FAILED");
+	}
+	return passed;
+}
+
+template<class T>
+static T fastAtan(T x, Accuracy accuracy)
+{
+	switch (accuracy)
+	{
+	case Accuracy::Low: return FastMath<T>::template atan<Accuracy::Low>(x);
+	case Accuracy::Medium: return FastMath<T>::template atan<Accuracy::Medium>(x);
+	default: return FastMath<T>::template atan<Accuracy::High>(x);
+	}
+}
+
+template<class T>
+static T fastAtanh(T x, Accuracy accuracy)
+{
+	switch (accuracy)
+	{
+	case Accuracy::Low: return FastMath<T>::template atanh<Accuracy::Low>(x);
+	case Accuracy::Medium: return FastMath<T>::template atanh<Accuracy::Medium>(x);
+	default: return FastMath<T>::template atanh<Accuracy::High>(x);
+	}
+}
+
+/*===================================================================================*/
+/*
+	[Function] The block versions must give the per-sample results exactly
+*/
+template<class T>
+static bool blockMatches()
+{
+	T buffer[257], expected[257];
+	for (int i = 0; i < 257; i++)
+	{
+		buffer[i] = static_cast<T>(i - 128) / T(100);
+		expected[i] = T(0.5) * FastMath<T>::template atan<Accuracy::Medium>(T(3) * buffer[i]);
+	}
+	FastMath<T>::template atanBlock<Accuracy::Medium>(buffer, 257, T(3), T(0.5));
+	return std::memcmp(buffer, expected, sizeof(buffer)) == 0;
+}
+
+int main()
+{
+	// --- the table in FastMath.h; the sweeps are coarser than the ones it was measured on,
+	//     but cover the same range (every exponent, both signs)
+	const Bounds atanFloat{ "atan", 6.1e-4, 1.2e-5, 1.8e-7 };
+	const Bounds atanhFloat{ "atanh", 2.5e-6, 5.6e-7, 5.4e-7 };
+	const Bounds atanDouble{ "atan", 6.1e-4, 1.2e-5, 3.8e-8 };
+	const Bounds atanhDouble{ "atanh", 2.0e-6, 1.1e-8, 6.5e-11 };
+
+	auto all = [](float) { return true; };
+	auto open = [](float x) { return x > -1.0f && x < 1.0f; };
+	auto atan = [](double x) { return std::atan(x); };
+	auto atanh = [](double x) { return std::atanh(x); };
+
+	bool passed = true;
+	passed &= sweep<float>(atanFloat, "float", 127, fastAtan<float>, atan, all);
+	passed &= sweep<double>(atanDouble, "double", 127, fastAtan<double>, atan, all);
+	passed &= sweep<float>(atanhFloat, "float", 47, fastAtanh<float>, atanh, open);
+	passed &= sweep<double>(atanhDouble, "double", 47, fastAtanh<double>, atanh, open);
+
+	const bool blocks = blockMatches<float>() && blockMatches<double>();
+	std::printf("block versions match the per-sample ones: %s\n", blocks ? "ok" : "FAILED");
+	passed &= blocks;
+	return passed ? 0 : 1;
+}
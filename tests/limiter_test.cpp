@@ -0,0 +1,78 @@
+/*
+*			AuxPort Limiter test
+			Runs sines from 20 Hz up through the Limiter at several lookaheads and sample rates,
+			in uneven block sizes, and checks the output never exceeds the ceiling.
+			See LICENSE in the repository root.
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "Limiter.h"
+using namespace AuxPort;
+
+/*===================================================================================*/
+/*
+	[Function] Peak of the limited sine, or a negative value if the limiter did nothing
+*/
+template<class T>
+static double limitedPeak(double sampleRate, double lookaheadMs, double frequency, double amplitude, double ceilingDb)
+{
+	Limiter<T> limiter;
+	limiter.setLookahead(lookaheadMs);
+	limiter.prepare(sampleRate);
+	limiter.setEnabled(true);
+	limiter.setCeiling(ceilingDb);
+	limiter.setRelease(50.0);
+
+	const size_t length = static_cast<size_t>(sampleRate);
+	std::vector<T> signal(length);
+	for (size_t i = 0; i < length; i++)
+		signal[i] = static_cast<T>(amplitude * std::sin(2.0 * 3.14159265358979323846 * frequency * static_cast<double>(i) / sampleRate));
+
+	static const size_t blocks[] = { 1, 7, 64, 256, 300, 1024 };
+	size_t b = 0;
+	for (size_t start = 0; start < length; b++)
+	{
+		const size_t count = std::min(blocks[b % 6], length - start);
+		limiter.process(signal.data() + start, count);
+		start += count;
+	}
+	double peak = 0.0;
+	for (const T& x : signal)
+		peak = std::max(peak, std::fabs(static_cast<double>(x)));
+	return peak;
+}
+
+template<class T>
+static bool run(const char* type, double tolerance)
+{
+	static const double sampleRates[] = { 44100.0, 48000.0, 96000.0 };
+	static const double lookaheads[] = { 0.05, 1.0, 5.0, 20.0 };
+	static const double frequencies[] = { 20.0, 60.0, 1000.0 };
+	const double ceilingDb = -6.0;
+	const double ceiling = std::pow(10.0, ceilingDb / 20.0);
+	bool ok = true;
+	for (double sampleRate : sampleRates)
+		for (double lookahead : lookaheads)
+			for (double frequency : frequencies)
+			{
+				const double peak = limitedPeak<T>(sampleRate, lookahead, frequency, 0.9, ceilingDb);
+				const bool pass = peak <= ceiling * (1.0 + tolerance) && peak > 0.5 * ceiling;
+				if (!pass)
+				{
+					std::printf("%s %g Hz at %g Hz, %g ms lookahead: peak %.9g, ceiling %.9g FAILED\n",
+						type, frequency, sampleRate, lookahead, peak, ceiling);
+					ok = false;
+				}
+			}
+	std::printf("%s limiter ceiling %s\n", type, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int main()
+{
+	bool ok = run<double>("double", 1e-12);
+	ok = run<float>("float", 1e-6) && ok;
+	return ok ? 0 : 1;
+}
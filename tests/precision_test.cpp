@@ -0,0 +1,113 @@
+/*
+*			AuxPort precision test
+			Renders the same input through ProductionEffect (float) and ReferenceEffect (double)
+			and checks the float path stays within the bound stated with the aliases in
+			AudioEffect.h. Needs the ASPiK headers (see CMakeLists.txt).
+			See LICENSE in the repository root.
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "plugincore.h"
+using namespace AuxPort;
+
+static constexpr double sampleRate = 48000.0;
+static constexpr size_t numFrames = 96000;
+static constexpr size_t blockSize = 512;
+static constexpr double bound = 5e-5;		// max |float - double| relative to the output peak
+
+struct Scenario
+{
+	const char* name;
+	int crossoverMode;
+	bool limiter;
+};
+
+/*===================================================================================*/
+/*
+	[Function] Renders input through an Effect of either precision, a block at a time
+*/
+template<class EffectType, class T>
+static void render(EffectType& effect, float* controls, bool limiter, const std::vector<float>& left, const std::vector<float>& right, std::vector<double>& output)
+{
+	effect.bind({ controls, parameterTable.slotMap() });
+	effect.setLookahead(limiter ? 1.0 : 0.0);
+	effect.reset(static_cast<T>(sampleRate));
+	effect.prepareToPlay(static_cast<T>(sampleRate));
+	std::vector<T> l(blockSize), r(blockSize), out(blockSize);
+	output.resize(numFrames);
+	for (size_t start = 0; start < numFrames; start += blockSize)
+	{
+		const size_t count = std::min(blockSize, numFrames - start);
+		for (size_t i = 0; i < count; i++)
+		{
+			l[i] = static_cast<T>(left[start + i]);
+			r[i] = static_cast<T>(right[start + i]);
+		}
+		effect.run(l.data(), r.data(), out.data(), nullptr, count);
+		for (size_t i = 0; i < count; i++)
+			output[start + i] = static_cast<double>(out[i]);
+	}
+}
+
+int main()
+{
+	// --- 2 s of noisy stereo: a few partials plus white noise, different per side
+	std::vector<float> left(numFrames), right(numFrames);
+	uint32_t seed = 0x2545F491u;
+	for (size_t i = 0; i < numFrames; i++)
+	{
+		const double t = static_cast<double>(i) / sampleRate;
+		seed = seed * 1664525u + 1013904223u;
+		const double noise = static_cast<double>(seed >> 8) * (2.0 / 16777216.0) - 1.0;
+		left[i] = static_cast<float>(0.5 * std::sin(2.0 * kPi * 110.0 * t) + 0.2 * std::sin(2.0 * kPi * 1870.0 * t) + 0.1 * noise);
+		right[i] = static_cast<float>(0.4 * std::sin(2.0 * kPi * 165.0 * t + 1.0) + 0.2 * std::sin(2.0 * kPi * 5200.0 * t) + 0.1 * noise);
+	}
+
+	const Scenario scenarios[] = {
+		{ "built-in flow", 0, false },
+		{ "LR2 crossover", 1, false },
+		{ "LR4 crossover", 2, false },
+		{ "limiter", 0, true }
+	};
+	bool passed = true;
+	for (const Scenario& scenario : scenarios)
+	{
+		float controls[parameterTable.size()];
+		parameterTable.setDefaults(controls);
+		auto set = [&](int id, float value) { controls[parameterTable.slotOf(id)] = value; };
+		set(controlID::preGain, 1.5f);
+		set(controlID::lowPassFC, 700.0f);
+		set(controlID::highPassFC, 3000.0f);
+		set(controlID::bandPassFC, 1200.0f);
+		set(controlID::bandPassQ, 3.0f);
+		set(controlID::fullWaveSwitch, 1.0f);
+		set(controlID::A1, 0.6f);
+		set(controlID::A2, 0.4f);
+		set(controlID::masterD, 0.8f);
+		set(controlID::masterC, 0.3f);
+		set(controlID::crossoverMode, static_cast<float>(scenario.crossoverMode));
+		set(controlID::limiterSwitch, scenario.limiter ? 1.0f : 0.0f);
+		set(controlID::limiterCeiling, -6.0f);
+
+		std::vector<double> production, reference;
+		ProductionEffect fast;
+		ReferenceEffect exact;
+		render<ProductionEffect, float>(fast, controls, scenario.limiter, left, right, production);
+		render<ReferenceEffect, double>(exact, controls, scenario.limiter, left, right, reference);
+
+		double peak = 0.0, error = 0.0;
+		for (size_t i = 0; i < numFrames; i++)
+		{
+			peak = std::max(peak, std::fabs(reference[i]));
+			error = std::max(error, std::fabs(production[i] - reference[i]));
+		}
+		const double relative = peak > 0.0 ? error / peak : error;
+		const bool ok = peak > 0.0 && relative <= bound;
+		passed = passed && ok;
+		std::printf("%-14s max error %.3g on a %.3g peak (%.3g relative, bound %.3g) %s\n", scenario.name, error, peak, relative, bound, ok ? "ok" : "FAILED");
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+// -----------------------------------------------------------------------------
+//    batchrender: command line front end for AuxPort::BatchRenderer
+//
+//    Build it next to the plugin kernel (same include paths as plugincore.cpp):
+//
+//    batchrender --manifest jobs.txt [--workers N] [--journal file] [--stats file]
+//    batchrender --watch inDir outDir [Name=value ...] [--idle-exit ms] [--workers N] ...
+//
+//    Restarting with the same journal resumes an interrupted run.
+// -----------------------------------------------------------------------------
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "BatchRender.h"
+
+static std::atomic<bool> stopRequested{ false };
+
+static void onSignal(int)
+{
+	stopRequested = true;
+}
+
+int main(int argc, char** argv)
+{
+	std::string manifest, watchIn, watchOut;
+	std::string journal = "batchrender.journal";
+	std::string stats = "batchrender.stats";
+	unsigned workers = 0;
+	unsigned idleExitMs = 0;
+	AuxPort::EffectSettings settings;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--manifest" && i + 1 < argc)
+			manifest = argv[++i];
+		else if (arg == "--watch" && i + 2 < argc)
+		{
+			watchIn = argv[++i];
+			watchOut = argv[++i];
+		}
+		else if (arg == "--workers" && i + 1 < argc)
+			workers = static_cast<unsigned>(std::atoi(argv[++i]));
+		else if (arg == "--journal" && i + 1 < argc)
+			journal = argv[++i];
+		else if (arg == "--stats" && i + 1 < argc)
+			stats = argv[++i];
+		else if (arg == "--idle-exit" && i + 1 < argc)
+			idleExitMs = static_cast<unsigned>(std::atoi(argv[++i]));
+		else if (arg.find('=') != std::string::npos && settings.set(arg.substr(0, arg.find('=')), std::atof(arg.c_str() + arg.find('=') + 1)))
+			continue;
+		else
+		{
+			std::cerr << "batchrender: unknown argument " << arg << "\n";
+			return 2;
+		}
+	}
+
+	AuxPort::BatchRenderer renderer(journal, stats, workers);
+	if (!manifest.empty())
+	{
+		std::vector<AuxPort::BatchJob> jobs;
+		std::string error;
+		if (!AuxPort::BatchRenderer::readManifest(manifest, jobs, error))
+		{
+			std::cerr << "batchrender: " << error << "\n";
+			return 2;
+		}
+		return renderer.run(jobs) == 0 ? 0 : 1;
+	}
+	if (!watchIn.empty())
+	{
+		std::signal(SIGINT, onSignal);
+		std::signal(SIGTERM, onSignal);
+		renderer.watch(watchIn, watchOut, settings, stopRequested, 1000, idleExitMs);
+		return 0;
+	}
+	std::cerr << "usage: batchrender --manifest file | --watch inDir outDir [Name=value ...]\n";
+	return 2;
+}